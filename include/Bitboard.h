@@ -0,0 +1,160 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+#ifdef CHESS_USE_PEXT
+#include <immintrin.h>
+#endif
+
+// A bitboard is a set of squares, one bit per square.
+// Squares are numbered row * 8 + col, the same layout Chess uses:
+// square 0 is row 0, col 0 (a8) and square 63 is row 7, col 7 (h1).
+using Bitboard = std::uint64_t;
+
+constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H = FILE_A << 7;
+constexpr Bitboard ROW_0 = 0xFFULL;
+constexpr Bitboard ROW_7 = ROW_0 << 56;
+// Squares of the same color as a8 and h1
+constexpr Bitboard LIGHT_SQUARES = 0xAA55AA55AA55AA55ULL;
+
+constexpr int squareOf(int row, int col) { return row * 8 + col; }
+constexpr int rowOf(int square) { return square >> 3; }
+constexpr int colOf(int square) { return square & 7; }
+constexpr Bitboard squareBB(int square) { return Bitboard(1) << square; }
+
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+
+// Returns the lowest square in the set and removes it
+inline int popLsb(Bitboard &b) {
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+// Shifts by one square; "north" is towards row 0
+constexpr Bitboard shiftNorth(Bitboard b) { return b >> 8; }
+constexpr Bitboard shiftSouth(Bitboard b) { return b << 8; }
+constexpr Bitboard shiftEast(Bitboard b) { return (b << 1) & ~FILE_A; }
+constexpr Bitboard shiftWest(Bitboard b) { return (b >> 1) & ~FILE_H; }
+
+constexpr Bitboard knightAttacks(Bitboard b) {
+    Bitboard l1 = (b >> 1) & ~FILE_H;
+    Bitboard l2 = (b >> 2) & ~(FILE_H | (FILE_H >> 1));
+    Bitboard r1 = (b << 1) & ~FILE_A;
+    Bitboard r2 = (b << 2) & ~(FILE_A | (FILE_A << 1));
+    Bitboard h1 = l1 | r1;
+    Bitboard h2 = l2 | r2;
+    return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+}
+
+constexpr Bitboard kingAttacks(Bitboard b) {
+    Bitboard row = b | shiftEast(b) | shiftWest(b);
+    return (row | shiftNorth(row) | shiftSouth(row)) & ~b;
+}
+
+// Squares attacked by a set of pawns; white pawns move towards row 0
+constexpr Bitboard pawnAttacks(Bitboard pawns, bool white) {
+    Bitboard ahead = white ? shiftNorth(pawns) : shiftSouth(pawns);
+    return shiftEast(ahead) | shiftWest(ahead);
+}
+
+// Per-square lookup tables, generated at compile time
+struct AttackTables {
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64];        // [0] white, [1] black
+    Bitboard between[64][64];    // squares strictly between two aligned squares
+    Bitboard line[64][64];       // whole board line through two aligned squares
+};
+
+constexpr AttackTables makeAttackTables() {
+    AttackTables tables{};
+    for (int square = 0; square < 64; ++square) {
+        Bitboard bit = squareBB(square);
+        tables.knight[square] = knightAttacks(bit);
+        tables.king[square] = kingAttacks(bit);
+        tables.pawn[0][square] = pawnAttacks(bit, true);
+        tables.pawn[1][square] = pawnAttacks(bit, false);
+    }
+    const int dirs[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+    for (int from = 0; from < 64; ++from) {
+        for (const auto& dir : dirs) {
+            // The full line runs both ways from the square through it
+            Bitboard full = squareBB(from);
+            for (int sign = -1; sign <= 1; sign += 2) {
+                int r = rowOf(from) + sign * dir[0];
+                int c = colOf(from) + sign * dir[1];
+                while (r >= 0 && r < 8 && c >= 0 && c < 8) {
+                    full |= squareBB(squareOf(r, c));
+                    r += sign * dir[0];
+                    c += sign * dir[1];
+                }
+            }
+            Bitboard path = 0;
+            int r = rowOf(from) + dir[0];
+            int c = colOf(from) + dir[1];
+            while (r >= 0 && r < 8 && c >= 0 && c < 8) {
+                tables.between[from][squareOf(r, c)] = path;
+                tables.line[from][squareOf(r, c)] = full;
+                path |= squareBB(squareOf(r, c));
+                r += dir[0];
+                c += dir[1];
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr AttackTables ATTACKS = makeAttackTables();
+
+constexpr Bitboard knightAttacksFrom(int square) { return ATTACKS.knight[square]; }
+constexpr Bitboard kingAttacksFrom(int square) { return ATTACKS.king[square]; }
+constexpr Bitboard pawnAttacksFrom(int square, bool white) { return ATTACKS.pawn[white ? 0 : 1][square]; }
+// Empty when the squares do not share a row, column or diagonal
+constexpr Bitboard betweenBB(int from, int to) { return ATTACKS.between[from][to]; }
+constexpr Bitboard lineBB(int from, int to) { return ATTACKS.line[from][to]; }
+
+// Sliding attacks come from magic bitboards: the blockers on a piece's rays
+// are hashed into an index of a precomputed attack table. Built with
+// CHESS_USE_PEXT the index is the BMI2 PEXT of the blockers instead, which
+// needs no multiply but is slow on CPUs that emulate PEXT in microcode.
+struct Magic {
+    Bitboard mask;              // ray squares whose occupancy matters
+    Bitboard magic;
+    const Bitboard* attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#ifdef CHESS_USE_PEXT
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic BISHOP_MAGICS[64];
+extern Magic ROOK_MAGICS[64];
+
+// Fills the magic tables. Runs during static initialization and from the
+// Chess constructor; later calls return immediately.
+void initSliderAttacks();
+
+inline Bitboard bishopAttacks(int square, Bitboard occupied) {
+    const Magic& m = BISHOP_MAGICS[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(int square, Bitboard occupied) {
+    const Magic& m = ROOK_MAGICS[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int square, Bitboard occupied) {
+    return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+}
+
+#endif // BITBOARD_H
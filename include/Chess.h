@@ -2,8 +2,15 @@
 #define CHESS_H
 
 #include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <utility>
+#include "Bitboard.h"
+#include "GameStatus.h"
+#include "Move.h"
+
+class PositionCache;
 
 enum class PieceType {
     EMPTY,
@@ -37,6 +44,15 @@ public:
     
     // Board management
     void resetBoard();
+    // Sets up the position from Forsyth-Edwards Notation; returns false and
+    // leaves the position unchanged if the text is not a valid FEN
+    bool loadFen(std::string_view fen);
+    // Writes the position as FEN (no terminating NUL) into out, which must
+    // hold MAX_FEN_LENGTH characters, and returns the length. writeFen does
+    // not allocate; toFen is the convenient form.
+    static constexpr int MAX_FEN_LENGTH = 96;
+    int writeFen(char* out) const;
+    std::string toFen() const;
     const Piece& getPiece(int row, int col) const;
     void setPiece(int row, int col, const Piece& piece);
     
@@ -45,20 +61,162 @@ public:
     bool movePiece(int fromRow, int fromCol, int toRow, int toCol);
     void promotePawn(int row, int col, PieceType newType);
     
-    // Game state
+    // Game state. getStatus() is worked out on first use after a change to
+    // the position and then served from a cache; the other getters below
+    // read from it too.
     PieceColor getCurrentPlayer() const;
+    const GameStatus& getStatus() const;
+    const LegalMoveTable& getLegalMoveTable() const;
     bool isGameOver() const;
     bool isCheckmate() const;
     bool isStalemate() const;
     bool isCheck() const;
     bool hasAnyLegalMove(PieceColor color) const;
     
-    // Helper methods
-    std::vector<std::pair<int, int>> getValidMoves(int row, int col) const;
+    // Pieces of either color attacking (row, col), as a bitboard
+    Bitboard attackersTo(int row, int col) const;
+    
+    // Piece sets; type EMPTY gives every piece of the color
+    Bitboard getPieces(PieceColor color, PieceType type) const;
+    
+    // Move generation (legal moves only)
+    MoveList getValidMoves(int row, int col) const;
+    MoveList generateMoves(PieceColor color) const;
+    // Looks a move in UCI notation ("e2e4", "e7e8q") up among the legal
+    // moves of the side to move; returns Move::none() if it is not one
+    Move parseUciMove(std::string_view text) const;
+    // Same for standard algebraic notation ("Nf3", "exd5", "e8=Q+", "O-O").
+    // Ambiguous or illegal moves give Move::none().
+    Move parseSanMove(std::string_view text) const;
+    
+    // Best move found by the built-in engine within timeMs (see Search.h)
+    Move bestMove(int timeMs, int threads = 1) const;
+    
+    // Look-ahead: play a move from generateMoves and take it back again.
+    // makeMove does not check legality; unmakeMove reverts the last makeMove.
+    void makeMove(Move move);
+    void unmakeMove();
+    bool canUnmakeMove() const;
+    
+    // For game records (see GameRecord.h): the last move played and what it
+    // overwrote, packed into 32 bits. Both require canUnmakeMove().
+    Move lastMove() const;
+    std::uint32_t lastUndoState() const;
+    // Takes back move, the last move played, from its lastUndoState. Unlike
+    // unmakeMove this also works when the move is no longer on the undo
+    // stack, e.g. after the position was set up again with loadFen.
+    void unmakeMove(Move move, std::uint32_t undoState);
+    
+    // Castling rights, as a mask of the CastlingRight bits
+    enum CastlingRight {
+        WHITE_KINGSIDE = 1,
+        WHITE_QUEENSIDE = 2,
+        BLACK_KINGSIDE = 4,
+        BLACK_QUEENSIDE = 8
+    };
+    int getCastlingRights() const;
+    // Square a pawn may capture onto en passant, -1 if none
+    int getEnPassantSquare() const;
+    // Plies since the last capture or pawn move, and the move number, as
+    // in FEN
+    int getHalfmoveClock() const;
+    int getFullmoveNumber() const;
+    // Whether the position occurred before since the last capture or pawn
+    // move; the search scores such positions as draws
+    bool isRepetition() const;
+    
+    // Zobrist key of the position, updated incrementally as it changes
+    std::uint64_t getPositionKey() const;
+    // Zobrist key of the pawns alone, for caching pawn-structure terms
+    std::uint64_t getPawnKey() const;
+    
+    // Static evaluation in centipawns from the side to move's point of view:
+    // material, piece-square tables, mobility and pawn structure, tapered
+    // between middlegame and endgame (see Evaluation.h)
+    int evaluate() const;
+    
+    // Optional cache, possibly shared between instances and threads, that
+    // remembers legal moves and check status per position. Not owned.
+    void setPositionCache(PositionCache* cache);
     
 private:
-    mutable std::array<std::array<Piece, 8>, 8> board;
+    // Everything makeMove overwrites that cannot be derived from the move
+    struct UndoInfo {
+        Move move;
+        Piece captured;
+        std::uint8_t castlingRights;
+        std::int8_t enPassantSquare;
+        std::uint16_t halfmoveClock;
+        std::uint64_t positionKey;
+    };
+    
+    // Deep enough for any search; a longer game simply grows the stack
+    static constexpr int UNDO_RESERVE = 1024;
+    
+    // What legal move generation needs to know about one side's king,
+    // worked out once per position instead of once per candidate move
+    struct MoveContext {
+        PieceColor color;
+        int king;            // -1 in hand-made positions without a king
+        Bitboard checkers;
+        Bitboard checkMask;  // where a non-king move must land: everywhere
+                             // when not in check, nowhere in double check
+        Bitboard pinned;     // own pieces that may only move along their pin
+    };
+    
+    // Mailbox mirror of the bitboards so getPiece can hand out references
+    std::array<Piece, 64> squares;
+    // One set per color and piece type (indexed by PieceType), plus occupancy
+    std::array<std::array<Bitboard, 7>, 2> pieceBB;
+    std::array<Bitboard, 2> colorBB;
+    Bitboard occupiedBB;
+    // King squares kept up to date by putPiece/removePiece, -1 if absent
+    std::array<int, 2> kingSquare;
     PieceColor currentPlayer;
+    int castlingRights;
+    int enPassantSquare;
+    std::uint64_t positionKey;
+    std::uint64_t pawnKey;
+    int halfmoveClock;
+    int fullmoveNumber;
+    // Keys of the positions before each move played, by ply modulo the ring
+    // size, for repetition checks. Plies before keyFloor have been
+    // overwritten (or were never seen, e.g. before a loadFen).
+    static constexpr int KEY_HISTORY_SIZE = 1024;
+    std::array<std::uint64_t, KEY_HISTORY_SIZE> keyHistory;
+    int keyCount;
+    int keyFloor;
+    // Material plus piece-square sums (White minus Black) and game phase,
+    // kept up to date by putPiece/removePiece
+    int materialMg;
+    int materialEg;
+    int gamePhase;
+    std::vector<UndoInfo> undoStack;
+    PositionCache* positionCache;
+    // Cleared by everything that changes the position
+    mutable StatusCache statusCache;
+    
+    // Bitboard bookkeeping
+    void clearBoard();
+    void putPiece(int square, const Piece& piece);
+    void removePiece(int square);
+    void setCastlingRights(int rights);
+    void setEnPassantSquare(int square);
+    void restorePieces(Move move, const Piece& captured);
+    bool isLegal(Move move) const;
+    int moveFlag(int from, int to) const;
+    Bitboard pieceTargets(int square) const;
+    Bitboard castlingTargets(PieceColor color) const;
+    MoveContext moveContext(PieceColor color) const;
+    Bitboard legalTargets(int from, const MoveContext& context) const;
+    void addLegalMoves(int from, const MoveContext& context, MoveList& moves) const;
+    void addAllLegalMoves(PieceColor color, MoveList& moves) const;
+    bool cachedAnalysis(MoveList& moves, bool& inCheck) const;
+    void pushKey(std::uint64_t key);
+    void popKey();
+    int earlierOccurrences(int limit) const;
+    bool isThreefoldRepetition() const;
+    bool hasInsufficientMaterial() const;
     
     // Move validation helpers
     bool isPathClear(int fromRow, int fromCol, int toRow, int toCol) const;
@@ -73,6 +231,7 @@ private:
     bool isKingInCheck(PieceColor color) const;
     int findKingPosition(PieceColor color) const;
     bool isSquareAttacked(int row, int col, PieceColor byColor) const;
+    Bitboard attackersTo(int square, Bitboard occupied) const;
 };
 
 #endif // CHESS_H
@@ -3,6 +3,8 @@
 
 #include <QWidget>
 #include <QPoint>
+#include <QPixmap>
+#include <array>
 #include "Chess.h"
 
 class ChessBoard : public QWidget {
@@ -13,6 +15,11 @@ public:
     
     void setChessGame(Chess *game);
     void resetBoard();
+    // Ignore clicks, e.g. while the computer is thinking
+    void setInputEnabled(bool enabled);
+    // Repaint only the squares whose piece or highlight changed; call after
+    // changing the game from outside the widget
+    void refreshSquares();
     
 signals:
     void moveCompleted();
@@ -27,12 +34,36 @@ private:
     int squareSize;
     int selectedRow;
     int selectedCol;
+    bool inputEnabled;
     
     QPoint boardOffset;
+
+    // What each square shows: the piece in the low bits, highlights above
+    enum SquareHighlight {
+        CHECKED_KING = 1 << 8,
+        SELECTED = 1 << 9,
+        MOVE_TARGET = 1 << 10,
+        CAPTURE_TARGET = 1 << 11,
+        CAPTURABLE = 1 << 12
+    };
+    // As last sent to update(), to find the squares that need repainting
+    std::array<int, 64> shownStates;
+
+    // The empty board, and every piece pre-rendered once: one atlas cell per
+    // type (columns) and color (rows). Both are built for the size and pixel
+    // ratio below.
+    QPixmap boardBackground;
+    QPixmap pieceAtlas;
+    int cacheSquareSize;
+    qreal cachePixelRatio;
     
+    std::array<int, 64> computeSquareStates() const;
     void drawBoard(QPainter &painter);
-    void drawPieces(QPainter &painter);
-    void drawHighlights(QPainter &painter);
+    void drawHighlights(QPainter &painter, const QRect &rect, int state);
+    void ensureRenderCache();
+    void renderPieceGlyph(QPainter &painter, const QRect &rect, const Piece &piece) const;
+    QRect atlasCell(const Piece &piece) const;
+    QRect backgroundRect() const;
     
     void getSquareFromPoint(const QPoint &point, int &row, int &col) const;
     QRect getSquareRect(int row, int col) const;
@@ -0,0 +1,24 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "Chess.h"
+
+// Weights behind Chess::evaluate(). Scores are centipawns, positive for
+// White, with separate middlegame and endgame values that are blended by
+// the game phase.
+
+// Phase contributed by each piece type (indexed by PieceType); all pieces
+// on the board add up to MAX_PHASE, bare kings to 0
+constexpr int PHASE_WEIGHTS[7] = {0, 0, 1, 1, 2, 4, 0};
+constexpr int MAX_PHASE = 24;
+
+// Material plus piece-square value of a piece, already signed by color,
+// indexed by color (0 = White), PieceType and square
+struct PieceSquareTables {
+    int mg[2][7][64];
+    int eg[2][7][64];
+};
+
+extern const PieceSquareTables PIECE_SQUARE;
+
+#endif // EVALUATION_H
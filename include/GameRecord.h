@@ -0,0 +1,85 @@
+#ifndef GAMERECORD_H
+#define GAMERECORD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Chess.h"
+
+// The moves of one game, for taking moves back, replaying them and jumping
+// to any ply. A record does not hold a position: it steers the Chess it is
+// given, which must be the one the moves were played on.
+//
+// Each ply is stored in 8 bytes, the 16-bit move and the state
+// Chess::lastUndoState packs (captured piece, castling rights, en passant
+// square, halfmove clock), so undo and redo are a single unmake or make.
+// Every CHECKPOINT_INTERVAL plies the position is also kept as FEN, and
+// seek() starts from the nearest checkpoint whenever that is shorter than
+// stepping there, so a jump costs at most one loadFen and an interval of
+// moves. The moves and checkpoints of a 300-ply game take about 3.5 KB.
+//
+// A position loaded from a checkpoint knows nothing of the moves before
+// it, so the record starts far enough back to replay every position since
+// the last capture or pawn move, and repetitions are still recognised.
+class GameRecord {
+public:
+    static constexpr int CHECKPOINT_INTERVAL = 32;
+
+    GameRecord() = default;
+    explicit GameRecord(const Chess& start) { reset(start); }
+
+    // Starts an empty record at the position
+    void reset(const Chess& start);
+
+    // Records the move just played on position (Chess::lastMove), after
+    // promotePawn if it was a promotion. Moves that could have been redone
+    // are dropped.
+    void recordLastMove(const Chess& position);
+    // Plays a legal move on position and records it
+    void play(Chess& position, Move move);
+
+    // Plies from the start to the current position, and in the whole record
+    int ply() const { return current; }
+    int length() const { return static_cast<int>(plies.size()); }
+    bool canUndo() const { return current > 0; }
+    bool canRedo() const { return current < length(); }
+    // Move leading from ply to ply + 1
+    Move moveAt(int ply) const { return plies[ply].move; }
+
+    // Each returns false, leaving position alone, if there is nothing to do
+    bool undo(Chess& position);
+    bool redo(Chess& position);
+    // Goes to any ply from 0 to length()
+    bool seek(Chess& position, int ply);
+
+    // Heap memory held by the record, in bytes
+    std::size_t memoryUsage() const;
+
+private:
+    struct Ply {
+        Move move;
+        std::uint32_t undoState;
+    };
+
+    struct Checkpoint {
+        std::array<char, Chess::MAX_FEN_LENGTH> fen;
+        int length;
+        int halfmoveClock;
+    };
+
+    std::vector<Ply> plies;
+    // Position at ply i * CHECKPOINT_INTERVAL, starting with ply 0
+    std::vector<Checkpoint> checkpoints;
+    int current = 0;
+    // First ply the position has been played through since it was last
+    // loaded from a checkpoint
+    int historyStart = 0;
+
+    void addCheckpoint(const Chess& position);
+    int restorePoint(int ply) const;
+    void restore(Chess& position, int ply);
+    bool missesHistory(const Chess& position) const;
+};
+
+#endif // GAMERECORD_H
@@ -0,0 +1,93 @@
+#ifndef GAMESTATUS_H
+#define GAMESTATUS_H
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include "Bitboard.h"
+
+enum class DrawReason {
+    NONE,
+    STALEMATE,
+    FIFTY_MOVES,            // 100 plies without a capture or pawn move
+    REPETITION,             // the same position for the third time
+    INSUFFICIENT_MATERIAL   // no sequence of moves can mate
+};
+
+// Legal moves of the side to move in a form a board view can read directly
+struct LegalMoveTable {
+    std::array<Bitboard, 64> targets{};  // by from-square
+    Bitboard captureTargets = 0;         // enemy pieces that can be taken
+};
+
+// Everything the UI asks about the position after a move
+struct GameStatus {
+    bool inCheck = false;
+    int legalMoveCount = 0;
+    bool checkmate = false;
+    bool stalemate = false;
+    DrawReason drawReason = DrawReason::NONE;
+    LegalMoveTable moves;
+
+    bool isOver() const { return checkmate || drawReason != DrawReason::NONE; }
+};
+
+// A GameStatus computed on first request and kept until invalidate().
+// Const readers on several threads may race to fill it: one computes while
+// the others wait, so the work is done once. Copies carry the status over
+// only if it is complete.
+class StatusCache {
+public:
+    StatusCache() : state(UNKNOWN) {}
+
+    StatusCache(const StatusCache& other) : state(UNKNOWN) {
+        copyFrom(other);
+    }
+
+    StatusCache& operator=(const StatusCache& other) {
+        if (this != &other) {
+            state.store(UNKNOWN, std::memory_order_relaxed);
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    // Not to be called while other threads are reading
+    void invalidate() {
+        state.store(UNKNOWN, std::memory_order_relaxed);
+    }
+
+    // The status if it has been computed, otherwise nullptr
+    const GameStatus* ready() const {
+        return state.load(std::memory_order_acquire) == READY ? &status : nullptr;
+    }
+
+    template <typename Compute>
+    const GameStatus& get(Compute compute) {
+        int expected = UNKNOWN;
+        if (state.compare_exchange_strong(expected, BUSY, std::memory_order_acquire)) {
+            status = compute();
+            state.store(READY, std::memory_order_release);
+            return status;
+        }
+        while (state.load(std::memory_order_acquire) != READY) {
+            std::this_thread::yield();
+        }
+        return status;
+    }
+
+private:
+    enum { UNKNOWN, BUSY, READY };
+
+    std::atomic<int> state;
+    GameStatus status;
+
+    void copyFrom(const StatusCache& other) {
+        if (const GameStatus* done = other.ready()) {
+            status = *done;
+            state.store(READY, std::memory_order_release);
+        }
+    }
+};
+
+#endif // GAMESTATUS_H
@@ -0,0 +1,180 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef CHESS_INSTRUMENT
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+// Optional counters and call timing inside Chess, compiled in with the
+// CHESS_INSTRUMENT build option. Without it the macros below expand to
+// nothing and the rest of this API reports an empty, disabled set of stats.
+//
+// Each thread counts into its own block, so the hot paths take no locks
+// and share no cache lines; collect() adds the blocks up on demand.
+// Latencies are in TSC cycles on x86 and nanoseconds elsewhere.
+
+// Internal steps counted on every call
+enum class HotPath {
+    IS_VALID_MOVE,
+    CAN_PIECE_MOVE,
+    IS_SQUARE_ATTACKED,
+    IS_KING_IN_CHECK,
+    HAS_ANY_LEGAL_MOVE,
+    COUNT
+};
+
+// Public calls timed into a latency histogram
+enum class ChessCall {
+    LOAD_FEN,
+    IS_VALID_MOVE,
+    MOVE_PIECE,
+    PROMOTE_PAWN,
+    GET_STATUS,
+    GET_VALID_MOVES,
+    GENERATE_MOVES,
+    HAS_ANY_LEGAL_MOVE,
+    MAKE_MOVE,
+    UNMAKE_MOVE,
+    COUNT
+};
+
+constexpr int HOT_PATH_COUNT = static_cast<int>(HotPath::COUNT);
+constexpr int CHESS_CALL_COUNT = static_cast<int>(ChessCall::COUNT);
+
+// Bucket 0 holds calls of 0 ticks and bucket i calls of [2^(i-1), 2^i)
+struct LatencyHistogram {
+    static constexpr int BUCKETS = 40;
+
+    std::uint64_t calls = 0;
+    std::uint64_t totalTicks = 0;
+    std::uint64_t maxTicks = 0;
+    std::array<std::uint64_t, BUCKETS> buckets{};
+
+    // Upper bound of the bucket holding the given fraction of calls
+    std::uint64_t percentile(double fraction) const;
+};
+
+struct InstrumentationStats {
+    bool enabled = false;
+    const char* tickUnit = "ns";
+    std::array<std::uint64_t, HOT_PATH_COUNT> counts{};
+    std::array<LatencyHistogram, CHESS_CALL_COUNT> calls{};
+};
+
+class Instrumentation {
+public:
+    static bool enabled();
+    static const char* name(HotPath path);
+    static const char* name(ChessCall call);
+
+    // Totals over every thread, including threads that have exited
+    static InstrumentationStats collect();
+    // Zeroes the counts; calls running meanwhile on other threads may be
+    // partly kept
+    static void reset();
+    static std::string toJson(const InstrumentationStats& stats);
+
+    // Chrome trace (chrome://tracing, Perfetto): while tracing, each timed
+    // call is also recorded as an event, up to maxEvents per thread. Events
+    // are kept across stop and start until clearTrace().
+    static void startTrace(std::size_t maxEvents = 1 << 16);
+    static void stopTrace();
+    static void clearTrace();
+    static std::string chromeTrace();
+
+#ifdef CHESS_INSTRUMENT
+    // A thread's counts, written only by that thread
+    struct Counters {
+        struct Call {
+            std::atomic<std::uint64_t> calls;
+            std::atomic<std::uint64_t> totalTicks;
+            std::atomic<std::uint64_t> maxTicks;
+            std::atomic<std::uint64_t> buckets[LatencyHistogram::BUCKETS];
+        };
+        std::atomic<std::uint64_t> counts[HOT_PATH_COUNT];
+        Call calls[CHESS_CALL_COUNT];
+    };
+
+    static inline thread_local Counters* threadCounters = nullptr;
+    static inline std::atomic<bool> tracing{false};
+
+    static Counters& counters() {
+        return threadCounters ? *threadCounters : registerThread();
+    }
+
+    static std::uint64_t ticks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // Owner-only update: no read-modify-write instruction needed
+    static void add(std::atomic<std::uint64_t>& value, std::uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static void count(HotPath path) {
+        add(counters().counts[static_cast<int>(path)], 1);
+    }
+
+    // Times the enclosing scope
+    class CallTimer {
+    public:
+        explicit CallTimer(ChessCall call)
+            : call(call), traceStart(tracing.load(std::memory_order_relaxed) ? traceClock() : 0),
+              start(ticks()) {}
+        ~CallTimer() { record(call, ticks() - start, traceStart); }
+
+        CallTimer(const CallTimer&) = delete;
+        CallTimer& operator=(const CallTimer&) = delete;
+
+    private:
+        ChessCall call;
+        std::uint64_t traceStart;
+        std::uint64_t start;
+    };
+
+private:
+    static Counters& registerThread();
+    static std::uint64_t traceClock();
+    static void addTraceEvent(ChessCall call, std::uint64_t start, std::uint64_t end);
+
+    static void record(ChessCall call, std::uint64_t elapsed, std::uint64_t traceStart) {
+        Counters::Call& entry = counters().calls[static_cast<int>(call)];
+        add(entry.calls, 1);
+        add(entry.totalTicks, elapsed);
+        if (elapsed > entry.maxTicks.load(std::memory_order_relaxed)) {
+            entry.maxTicks.store(elapsed, std::memory_order_relaxed);
+        }
+        int bucket = elapsed == 0 ? 0 : 64 - __builtin_clzll(elapsed);
+        add(entry.buckets[bucket < LatencyHistogram::BUCKETS ? bucket : LatencyHistogram::BUCKETS - 1], 1);
+        if (traceStart != 0) {
+            addTraceEvent(call, traceStart, traceClock());
+        }
+    }
+#endif
+};
+
+#ifdef CHESS_INSTRUMENT
+#define CHESS_COUNT(path) Instrumentation::count(path)
+#define CHESS_TIME_CALL(call) Instrumentation::CallTimer chessCallTimer(call)
+#else
+#define CHESS_COUNT(path) ((void)0)
+#define CHESS_TIME_CALL(call) ((void)0)
+#endif
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,34 @@
+#ifndef LARGEPAGEBUFFER_H
+#define LARGEPAGEBUFFER_H
+
+#include <cstddef>
+
+// Zero-filled, cache-line aligned memory block for large hash tables.
+// With hugePages set it asks the OS for huge/large pages and silently
+// falls back to ordinary pages when they are unavailable.
+class LargePageBuffer {
+public:
+    LargePageBuffer() = default;
+    LargePageBuffer(std::size_t bytes, bool hugePages);
+    ~LargePageBuffer();
+
+    LargePageBuffer(const LargePageBuffer&) = delete;
+    LargePageBuffer& operator=(const LargePageBuffer&) = delete;
+    LargePageBuffer(LargePageBuffer&& other) noexcept;
+    LargePageBuffer& operator=(LargePageBuffer&& other) noexcept;
+
+    void allocate(std::size_t bytes, bool hugePages);
+    void release();
+
+    void* data() const { return memory; }
+    std::size_t size() const { return bytes; }
+    bool usesHugePages() const { return hugePages; }
+
+private:
+    void* memory = nullptr;
+    std::size_t bytes = 0;
+    bool hugePages = false;
+    bool mapped = false;
+};
+
+#endif // LARGEPAGEBUFFER_H
@@ -3,8 +3,14 @@
 
 #include <QMainWindow>
 #include <QLabel>
+#include <QPushButton>
+#include <QThread>
 #include "Chess.h"
 #include "ChessBoard.h"
+#include "GameRecord.h"
+#include "Polyglot.h"
+#include "Search.h"
+#include "Tablebase.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -17,6 +23,10 @@ private slots:
     void resetGame();
     void updateStatus();
     void handlePromotion(int row, int col);
+    void handleMoveCompleted();
+    void toggleComputerOpponent();
+    void goBack();
+    void goForward();
 
 private:
     Chess *chessGame;
@@ -26,8 +36,37 @@ private:
     int promotionRow;
     int promotionCol;
     
+    // Moves of the current game, for stepping back and forward through it
+    GameRecord history;
+    QPushButton *backButton;
+    QPushButton *forwardButton;
+    
+    // Computer opponent, searching on a worker thread
+    QPushButton *computerButton;
+    bool vsComputer;
+    Search engine;
+    QThread *engineThread;
+    Move engineMove;
+    int engineGeneration;
+    
+    // Opening book, used for the computer's moves and shown in the status bar
+    PolyglotBook book;
+    QLabel *bookLabel;
+    
+    // Endgame tables, announcing forced results once few pieces are left
+    Tablebase tablebase;
+    QLabel *tablebaseLabel;
+    
     void setupUI();
     void connectSignals();
+    void startEngineIfNeeded();
+    void stopEngine();
+    void applyEngineMove(int generation);
+    void playComputerMove(Move move);
+    void showBookMoves();
+    void showTablebaseResult();
+    void showEngineInfo(const SearchInfo &info);
+    void showHistoryPosition();
 };
 
 #endif // MAINWINDOW_H
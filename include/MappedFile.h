@@ -0,0 +1,41 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory map of a whole file, for tools that scan large inputs
+// without copying them. An empty file maps to an empty view.
+class MappedFile {
+public:
+    // How the file will be read, passed on to the kernel as a paging hint:
+    // Sequential reads ahead for streams, Random pages in only what is
+    // touched, for lookups such as tablebase probes and book searches
+    enum class Access { Sequential, Random };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path, Access access = Access::Sequential);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false if the file cannot be opened or mapped
+    bool open(const std::string& path, Access access = Access::Sequential);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return memory; }
+    std::size_t size() const { return bytes; }
+    std::string_view view() const { return std::string_view(memory, bytes); }
+
+private:
+    const char* memory = nullptr;
+    std::size_t bytes = 0;
+    bool opened = false;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,111 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+// A move packed into 16 bits: from square (6 bits), to square (6 bits)
+// and a 4-bit flag. Squares use the row * 8 + col numbering from Bitboard.h.
+class Move {
+public:
+    enum Flag {
+        QUIET = 0,
+        DOUBLE_PUSH = 1,
+        KING_CASTLE = 2,
+        QUEEN_CASTLE = 3,
+        CAPTURE = 4,
+        EN_PASSANT = 5,
+        // Promotions add 0-3 for knight, bishop, rook, queen
+        PROMOTION = 8,
+        PROMOTION_CAPTURE = 12
+    };
+
+    // Left uninitialized so MoveList storage costs nothing; use Move::none() for an empty move
+    Move() = default;
+    constexpr Move(int from, int to, int flag = QUIET)
+        : data(static_cast<std::uint16_t>(from | (to << 6) | (flag << 12))) {}
+
+    static constexpr Move none() { return Move(0, 0); }
+    static constexpr Move fromRaw(std::uint16_t raw) {
+        Move move = none();
+        move.data = raw;
+        return move;
+    }
+
+    constexpr int from() const { return data & 0x3F; }
+    constexpr int to() const { return (data >> 6) & 0x3F; }
+    constexpr int flag() const { return data >> 12; }
+
+    constexpr int fromRow() const { return from() >> 3; }
+    constexpr int fromCol() const { return from() & 7; }
+    constexpr int toRow() const { return to() >> 3; }
+    constexpr int toCol() const { return to() & 7; }
+
+    constexpr bool isCapture() const { return (flag() & CAPTURE) != 0; }
+    constexpr bool isPromotion() const { return (flag() & PROMOTION) != 0; }
+    constexpr bool isCastle() const { return flag() == KING_CASTLE || flag() == QUEEN_CASTLE; }
+    // 0-3 for knight, bishop, rook, queen; only meaningful for promotions
+    constexpr int promotionIndex() const { return flag() & 3; }
+    constexpr bool isNone() const { return data == 0; }
+    constexpr std::uint16_t raw() const { return data; }
+
+    // Long algebraic notation as used by UCI, e.g. "e2e4" or "e7e8q"
+    std::string toUci() const {
+        std::string text;
+        text += static_cast<char>('a' + fromCol());
+        text += static_cast<char>('8' - fromRow());
+        text += static_cast<char>('a' + toCol());
+        text += static_cast<char>('8' - toRow());
+        if (isPromotion()) {
+            text += "nbrq"[promotionIndex()];
+        }
+        return text;
+    }
+
+    constexpr bool operator==(Move other) const { return data == other.data; }
+    constexpr bool operator!=(Move other) const { return data != other.data; }
+
+private:
+    std::uint16_t data;
+};
+
+// Fixed-capacity move container that lives on the stack.
+// 256 is above the 218 legal moves of the richest known position;
+// Chess::loadFen turns away positions that could have more.
+class MoveList {
+public:
+    static constexpr int CAPACITY = 256;
+
+    void add(Move move) {
+        assert(count < CAPACITY);
+        moves[count++] = move;
+    }
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move operator[](int index) const { return moves[index]; }
+    Move& operator[](int index) { return moves[index]; }
+
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+
+    bool contains(Move move) const {
+        for (int i = 0; i < count; ++i) {
+            if (moves[i] == move) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    Move moves[CAPACITY];
+    int count = 0;
+};
+
+#endif // MOVE_H
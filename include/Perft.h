@@ -0,0 +1,49 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Chess.h"
+#include "LargePageBuffer.h"
+
+// Transposition table for perft subtree counts, shared lock-free between
+// threads. Entries keep the key XORed with their data so torn writes
+// read back as misses.
+class PerftTable {
+public:
+    explicit PerftTable(std::size_t megabytes, bool hugePages = false);
+
+    PerftTable(const PerftTable&) = delete;
+    PerftTable& operator=(const PerftTable&) = delete;
+
+    bool probe(std::uint64_t key, int depth, std::uint64_t& nodes) const;
+    void store(std::uint64_t key, int depth, std::uint64_t nodes);
+
+private:
+    struct Entry {
+        std::atomic<std::uint64_t> check;  // key ^ data
+        std::atomic<std::uint64_t> data;   // nodes << 8 | depth
+    };
+
+    LargePageBuffer memory;
+    Entry* table = nullptr;
+    std::size_t entries = 0;
+};
+
+struct PerftResult {
+    Move move;
+    std::uint64_t nodes;
+};
+
+// Counts leaf nodes depth plies below the position. The last ply is
+// bulk-counted from the size of the move list rather than played.
+std::uint64_t perft(Chess& position, int depth, PerftTable* table = nullptr);
+
+// Per-root-move breakdown, with the root moves split across threads.
+// Results are in move generation order.
+std::vector<PerftResult> perftDivide(const Chess& position, int depth, int threads,
+                                     PerftTable* table = nullptr);
+
+#endif // PERFT_H
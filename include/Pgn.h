@@ -0,0 +1,55 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <cstddef>
+#include <string_view>
+#include "Chess.h"
+
+// Reading games from Portable Game Notation. Everything here works on views
+// into the caller's text (typically a MappedFile), so nothing is copied and
+// memory use does not depend on the size of the input.
+//
+// A game starts at a line beginning with '[' whose previous line does not,
+// i.e. at its first tag pair, and runs up to the start of the next game.
+
+// One game: its tag pairs and its movetext
+struct PgnGame {
+    std::size_t offset = 0;       // where the game starts in the text
+    std::string_view tags;
+    std::string_view movetext;
+
+    // Value of a tag pair such as [FEN "..."], empty if the tag is missing
+    std::string_view tag(std::string_view name) const;
+};
+
+// Start of the first game at or after offset, or text.size() if none
+std::size_t findGameStart(std::string_view text, std::size_t offset);
+
+// Walks the games of a text one after another
+class PgnReader {
+public:
+    explicit PgnReader(std::string_view text, std::size_t offset = 0)
+        : text(text), position(offset) {}
+
+    // Returns false at the end of the text
+    bool next(PgnGame& game);
+
+private:
+    std::string_view text;
+    std::size_t position;
+};
+
+struct ReplayResult {
+    int plies = 0;                // moves played
+    std::string_view error;       // move (or FEN) that failed, empty if none
+
+    bool ok() const { return error.empty(); }
+};
+
+// Plays a game from its starting position (the FEN tag if present) through
+// movePiece/promotePawn, resolving each SAN move against the legal moves.
+// Comments, variations, NAGs and move numbers are skipped; the game ends at
+// its result or the end of the movetext.
+ReplayResult replayGame(const PgnGame& game, Chess& position);
+
+#endif // PGN_H
@@ -0,0 +1,62 @@
+#ifndef POLYGLOT_H
+#define POLYGLOT_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Chess.h"
+#include "MappedFile.h"
+
+// Opening books in the Polyglot .bin format: 16-byte big-endian entries
+// (key, move, weight, learn) sorted by key. The book is memory-mapped and
+// searched in place, so opening even a very large book reads nothing.
+//
+// Polyglot keys are Zobrist keys over a fixed table of 781 "Random64"
+// numbers published with the format. That table is not part of this tree
+// and is read from a text file instead (781 hexadecimal numbers, in the
+// order of the specification); it is checked against the specification's
+// key for the starting position before use.
+
+class PolyglotKeys {
+public:
+    static constexpr int COUNT = 781;
+
+    // Returns false if the file cannot be read, does not hold exactly COUNT
+    // numbers, or gives the wrong starting position key
+    bool load(const std::string& path);
+    bool isLoaded() const { return loaded; }
+
+    std::uint64_t key(const Chess& position) const;
+
+private:
+    std::array<std::uint64_t, COUNT> randoms{};
+    bool loaded = false;
+};
+
+struct BookMove {
+    Move move;
+    int weight;
+};
+
+class PolyglotBook {
+public:
+    // Maps the book and loads the key table; false if either is unusable
+    bool open(const std::string& bookPath, const std::string& keysPath);
+    void close();
+    bool isOpen() const { return entryCount > 0 && keys.isLoaded(); }
+
+    // Legal book moves for the position, highest weight first
+    std::vector<BookMove> lookup(const Chess& position) const;
+
+    // A book move picked with probability proportional to its weight, using
+    // random as the source of randomness; Move::none() when out of book
+    Move pick(const Chess& position, std::uint64_t random) const;
+
+private:
+    MappedFile file;
+    std::size_t entryCount = 0;
+    PolyglotKeys keys;
+};
+
+#endif // POLYGLOT_H
@@ -0,0 +1,60 @@
+#ifndef POSITIONCACHE_H
+#define POSITIONCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "LargePageBuffer.h"
+#include "Move.h"
+
+// Fixed-size cache of per-position results keyed by Chess::getPositionKey().
+// Any number of threads may probe and store at once without locking: each
+// entry keeps its key XORed with its contents, so an entry torn by a
+// concurrent write fails verification and reads as a miss.
+class PositionCache {
+public:
+    // Positions with more legal moves than this are not cached
+    static constexpr int MAX_CACHED_MOVES = 64;
+    static constexpr int BUCKET_SIZE = 4;
+
+    // What is known about a position once its legal moves are generated;
+    // it is over (mate or stalemate) when moves is empty
+    struct Result {
+        MoveList moves;
+        bool inCheck = false;
+    };
+
+    explicit PositionCache(std::size_t megabytes = 16, bool hugePages = false);
+
+    PositionCache(const PositionCache&) = delete;
+    PositionCache& operator=(const PositionCache&) = delete;
+
+    // Not safe while other threads use the cache
+    void resize(std::size_t megabytes, bool hugePages = false);
+    void clear();
+
+    bool probe(std::uint64_t key, Result& result) const;
+    void store(std::uint64_t key, const Result& result);
+
+    std::size_t bucketCount() const { return buckets; }
+    bool usesHugePages() const { return memory.usesHugePages(); }
+
+private:
+    struct Entry {
+        std::atomic<std::uint64_t> check;   // key ^ header ^ used move words
+        std::atomic<std::uint64_t> header;  // move count, in-check bit, used bit
+        std::atomic<std::uint64_t> moves[MAX_CACHED_MOVES / 4];
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    LargePageBuffer memory;
+    Bucket* table = nullptr;
+    std::size_t buckets = 0;
+
+    Bucket& bucketFor(std::uint64_t key) const;
+};
+
+#endif // POSITIONCACHE_H
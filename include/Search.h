@@ -0,0 +1,91 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Chess.h"
+#include "TranspositionTable.h"
+
+// Progress report after each completed iteration
+struct SearchInfo {
+    int depth = 0;
+    int score = 0;              // centipawns from the side to move's view
+    std::uint64_t nodes = 0;
+    std::int64_t elapsedMs = 0; // time to reach this depth
+    std::int64_t elapsedUs = 0; // the same, for rates over short searches
+    Move bestMove = Move::none();
+
+    // 0 until any time has been measured
+    std::uint64_t nodesPerSecond() const {
+        return elapsedUs > 0 ? nodes * 1000000 / static_cast<std::uint64_t>(elapsedUs) : 0;
+    }
+};
+
+// Iterative-deepening principal variation search with a quiescence search
+// on captures. Moves are ordered by the hash move, MVV-LVA, killer moves
+// and history.
+//
+// With more than one thread the search is Lazy SMP: every thread searches
+// the same root on its own copy of the position, and they cooperate only
+// through the shared lock-free transposition table. The main thread decides
+// when to stop and its result is the one returned. Since all work happens
+// on copies, a Search can run on a worker thread while the caller keeps
+// using the original position.
+class Search {
+public:
+    static constexpr int MAX_PLY = 128;
+    static constexpr int MATE_SCORE = 32000;
+
+    using InfoCallback = std::function<void(const SearchInfo&)>;
+
+    explicit Search(int threads = 1, std::size_t hashMegabytes = 16);
+    ~Search();
+
+    Search(const Search&) = delete;
+    Search& operator=(const Search&) = delete;
+
+    // Not safe while a search is running
+    void setThreads(int threads);
+    int threadCount() const { return static_cast<int>(workers.size()); }
+    void setHashSize(std::size_t megabytes, bool hugePages = false);
+    void clearHash();
+
+    // Searches until timeMs has passed (no limit if timeMs <= 0), maxDepth
+    // is complete or stop() is called, and returns the best move of the last
+    // finished iteration. onIteration runs on the calling thread. Returns
+    // Move::none() if the side to move has no legal moves.
+    //
+    // A stop() made before bestMove begins is kept, so a search started on
+    // another thread can be cancelled at once: call prepare() on the
+    // controlling thread before starting that thread.
+    Move bestMove(const Chess& root, int timeMs, int maxDepth = MAX_PLY,
+                  const InfoCallback& onIteration = InfoCallback());
+
+    // Clears an earlier stop(); bestMove leaves it clear when it returns
+    void prepare();
+    // Asks a running (or about to run) search to return as soon as
+    // possible; thread-safe
+    void stop();
+
+    const SearchInfo& lastInfo() const { return info; }
+
+private:
+    class Worker;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    TranspositionTable table;
+    std::atomic<bool> stopRequested;
+    bool timeLimited;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point deadline;
+    SearchInfo info;
+
+    std::uint64_t totalNodes() const;
+};
+
+#endif // SEARCH_H
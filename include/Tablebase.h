@@ -0,0 +1,131 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Chess.h"
+#include "MappedFile.h"
+
+// Endgame tablebases: win, draw or loss and distance to mate for every
+// position of a small material balance. Tables are built offline by
+// tools/tbgen.cpp and memory-mapped here; a probe is one index computation
+// and one read.
+//
+// A table covers one balance, named by the white pieces then the black
+// ones, kings first ("KQvK", "KBNvK", "KRvKP"). The balance with the colors
+// swapped is probed through the same table.
+//
+// Castling is never possible in these positions and en passant rights are
+// not part of the index, so positions with either are not probed.
+
+struct TablebaseResult {
+    enum Outcome { LOSS = -1, DRAW = 0, WIN = 1 };
+
+    // From the side to move's point of view
+    Outcome outcome = DRAW;
+    // Plies until mate with best play: odd for a win, even for a loss, 0 if
+    // the side to move is already mated or the position is a draw
+    int pliesToMate = 0;
+};
+
+// Which pieces a table holds and how its positions are numbered: side to
+// move, then the white king's square folded by the board's symmetries, then
+// one square for each other piece. Without pawns all 8 symmetries apply and
+// the white king is kept in the a1-d1-d4 triangle (10 squares); with pawns
+// only the left-right mirror does and it is kept on files a-d (32 squares).
+// Every position has one index: identical pieces are taken in square order,
+// and a white king on the diagonal takes the smaller index of the position
+// and its reflection. Indices that decode to another placement are unused.
+class TablebaseLayout {
+public:
+    static constexpr int MAX_PIECES = 5;
+    using Squares = std::array<int, MAX_PIECES>;
+
+    // Parses a name such as "KBNvK"; pieces may come in any order after
+    // each king. Returns false for anything else or too many pieces.
+    static bool parse(std::string_view name, TablebaseLayout& layout);
+    // The layout of the position's material; false if it has too many
+    // pieces or not exactly one king a side
+    static bool ofPosition(const Chess& position, TablebaseLayout& layout);
+
+    // Canonical name: kings first, then queens, rooks, bishops, knights, pawns
+    std::string name() const;
+    // The same balance with the colors swapped
+    TablebaseLayout swapped() const;
+
+    int pieceCount() const { return count; }
+    const Piece& piece(int i) const { return pieces[i]; }
+    bool hasPawns() const;
+    std::uint64_t size() const;
+
+    // Index of a position with exactly this material. With swapColors the
+    // position is read with white and black exchanged (and the board turned
+    // over), for probing the balance with the colors swapped.
+    std::uint64_t index(const Chess& position, bool swapColors = false) const;
+    // Index from piece squares, in the order of piece(i)
+    std::uint64_t index(Squares squares, bool whiteToMove) const;
+    // Squares and side to move of an index; false if two pieces share a
+    // square or a pawn stands on the first or last rank
+    bool decode(std::uint64_t index, Squares& squares, bool& whiteToMove) const;
+    // FEN of decoded squares, for Chess::loadFen; out must hold
+    // Chess::MAX_FEN_LENGTH characters. Returns the length.
+    int writeFen(const Squares& squares, bool whiteToMove, char* out) const;
+
+private:
+    std::array<Piece, MAX_PIECES> pieces;
+    int count = 0;
+    int kingSlots = 0;
+
+    // Takes the pieces in any order; false unless each side has one king
+    bool assign(std::array<Piece, MAX_PIECES> list, int size);
+    std::uint64_t encode(Squares squares, int slot, bool whiteToMove) const;
+};
+
+// On-disk table: a 32-byte header followed by one packed entry per index,
+// bitsPerEntry bits each, least significant bit first. An entry is 0 for a
+// draw (or an index that is not a legal position) and pliesToMate + 1
+// otherwise. Eight zero bytes end the file so a probe can always read a
+// whole 64-bit word.
+struct TablebaseHeader {
+    static constexpr int SIZE = 32;
+    static constexpr int NAME_SIZE = 16;
+    static constexpr char MAGIC[5] = "CTB1";
+
+    int bitsPerEntry = 0;
+    std::string name;
+    std::uint64_t entries = 0;
+
+    void write(char* out) const;
+    bool read(const char* data, std::size_t size);
+};
+
+class Tablebase {
+public:
+    // Maps a table file; false if it cannot be read or is not a table
+    bool addTable(const std::string& path);
+    void close();
+
+    int tableCount() const { return static_cast<int>(tables.size()); }
+    // Whether a table for the balance, in either color order, is loaded
+    bool covers(const TablebaseLayout& layout) const;
+
+    // Looks the position up; false if no loaded table covers it
+    bool probe(const Chess& position, TablebaseResult& result) const;
+
+private:
+    struct Table {
+        TablebaseLayout layout;
+        MappedFile file;
+        int bitsPerEntry = 0;
+        const unsigned char* entries = nullptr;
+    };
+
+    std::vector<Table> tables;
+    std::map<std::string, std::size_t> byName;
+};
+
+#endif // TABLEBASE_H
@@ -0,0 +1,66 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "LargePageBuffer.h"
+#include "Move.h"
+
+// Search results keyed by Chess::getPositionKey(), shared lock-free by all
+// search threads. As in PerftTable, each entry stores its key XORed with
+// its data, so an entry torn by a concurrent write reads back as a miss.
+class TranspositionTable {
+public:
+    static constexpr int BUCKET_SIZE = 4;
+
+    enum Bound : std::uint8_t {
+        BOUND_NONE = 0,
+        BOUND_UPPER = 1,  // score <= stored score (failed low)
+        BOUND_LOWER = 2,  // score >= stored score (failed high)
+        BOUND_EXACT = 3
+    };
+
+    struct Hit {
+        Move move = Move::none();
+        int score = 0;
+        int depth = 0;
+        Bound bound = BOUND_NONE;
+    };
+
+    explicit TranspositionTable(std::size_t megabytes = 16, bool hugePages = false);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Not safe while other threads use the table
+    void resize(std::size_t megabytes, bool hugePages = false);
+    void clear();
+
+    // Called once per search so entries from older searches are replaced first
+    void newSearch();
+
+    bool probe(std::uint64_t key, Hit& hit) const;
+    void store(std::uint64_t key, Move move, int score, int depth, Bound bound);
+
+    std::size_t bucketCount() const { return buckets; }
+
+private:
+    struct Entry {
+        std::atomic<std::uint64_t> check;  // key ^ data
+        std::atomic<std::uint64_t> data;   // move | score | depth | bound | age
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    LargePageBuffer memory;
+    Bucket* table = nullptr;
+    std::size_t buckets = 0;
+    std::uint8_t age = 0;
+
+    Bucket& bucketFor(std::uint64_t key) const;
+};
+
+#endif // TRANSPOSITIONTABLE_H
@@ -0,0 +1,82 @@
+/*
+ * C interface to the chess rules engine, for calling it in-process from
+ * other languages (Python ctypes/cffi, Go cgo, ...).
+ *
+ * Positions are opaque handles. Separate handles may be used from separate
+ * threads at the same time; a single handle must not be shared unguarded.
+ * Moves are exchanged either as 16-bit encodings (see Move.h) or as UCI
+ * strings such as "e2e4" and "e7e8q".
+ */
+#ifndef CHESSCORE_H
+#define CHESSCORE_H
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define CHESSCORE_API
+#else
+#define CHESSCORE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct chess_position chess_position;
+
+typedef enum {
+    CHESS_STATUS_ONGOING = 0,
+    CHESS_STATUS_CHECK = 1,
+    CHESS_STATUS_CHECKMATE = 2,
+    CHESS_STATUS_STALEMATE = 3,
+    /* Fifty-move rule, threefold repetition or insufficient material */
+    CHESS_STATUS_DRAW = 4
+} chess_status;
+
+/* Largest number of moves chess_legal_moves can report */
+#define CHESS_MAX_MOVES 256
+
+/* Buffer size that always holds chess_position_get_fen output */
+#define CHESS_MAX_FEN 97
+
+/* Creation and destruction; the create functions return NULL on failure */
+CHESSCORE_API chess_position *chess_position_create(void);
+CHESSCORE_API chess_position *chess_position_from_fen(const char *fen);
+CHESSCORE_API chess_position *chess_position_clone(const chess_position *position);
+CHESSCORE_API void chess_position_destroy(chess_position *position);
+
+/* Returns 1 on success, 0 if the FEN is invalid (position unchanged) */
+CHESSCORE_API int chess_position_set_fen(chess_position *position, const char *fen);
+
+/* Writes the position as a NUL-terminated FEN and returns its length, or 0 if
+ * capacity is too small */
+CHESSCORE_API int chess_position_get_fen(const chess_position *position, char *out, int capacity);
+
+/* Writes up to capacity legal moves and returns how many there are */
+CHESSCORE_API int chess_legal_moves(const chess_position *position, uint16_t *moves, int capacity);
+
+/* Play a move; returns 1 if it was legal and applied, 0 otherwise */
+CHESSCORE_API int chess_apply_move(chess_position *position, uint16_t move);
+CHESSCORE_API int chess_apply_uci(chess_position *position, const char *uci);
+
+/* Take back the last applied move; returns 0 if there is none */
+CHESSCORE_API int chess_undo_move(chess_position *position);
+
+/* Writes the UCI text of a move (at most 5 characters plus NUL) into out */
+CHESSCORE_API void chess_move_to_uci(uint16_t move, char out[6]);
+
+CHESSCORE_API chess_status chess_get_status(const chess_position *position);
+
+/* 0 for white, 1 for black */
+CHESSCORE_API int chess_side_to_move(const chess_position *position);
+
+/* FEN letter of the piece on square (row * 8 + col, 0 = a8), or '.' if empty */
+CHESSCORE_API char chess_piece_at(const chess_position *position, int square);
+
+CHESSCORE_API uint64_t chess_position_key(const chess_position *position);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHESSCORE_H */
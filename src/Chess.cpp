@@ -1,48 +1,418 @@
 #include "Chess.h"
-#include <cmath>
+#include "Evaluation.h"
+#include "Instrumentation.h"
+#include "PositionCache.h"
+#include "Search.h"
 #include <algorithm>
 
-Chess::Chess() : currentPlayer(PieceColor::WHITE) {
+namespace {
+
+int colorIndex(PieceColor color) {
+    return color == PieceColor::WHITE ? 0 : 1;
+}
+
+PieceColor opponentOf(PieceColor color) {
+    return (color == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+}
+
+// Home squares of the kings and rooks
+constexpr int WHITE_KING_HOME = squareOf(7, 4);
+constexpr int BLACK_KING_HOME = squareOf(0, 4);
+
+// Rights that survive a move touching each square; moving from or
+// capturing on a king or rook home square gives up the matching rights
+int castlingKeepMask(int square) {
+    switch (square) {
+        case squareOf(7, 0): return ~Chess::WHITE_QUEENSIDE;
+        case squareOf(7, 7): return ~Chess::WHITE_KINGSIDE;
+        case WHITE_KING_HOME: return ~(Chess::WHITE_KINGSIDE | Chess::WHITE_QUEENSIDE);
+        case squareOf(0, 0): return ~Chess::BLACK_QUEENSIDE;
+        case squareOf(0, 7): return ~Chess::BLACK_KINGSIDE;
+        case BLACK_KING_HOME: return ~(Chess::BLACK_KINGSIDE | Chess::BLACK_QUEENSIDE);
+        default: return ~0;
+    }
+}
+
+// Random keys for Zobrist hashing, generated at compile time from a fixed seed
+struct ZobristKeys {
+    std::uint64_t pieces[2][7][64];
+    std::uint64_t castling[16];
+    std::uint64_t enPassant[8];
+    std::uint64_t blackToMove;
+};
+
+constexpr std::uint64_t splitMix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys{};
+    std::uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int color = 0; color < 2; ++color) {
+        for (int type = 1; type < 7; ++type) {
+            for (int square = 0; square < 64; ++square) {
+                keys.pieces[color][type][square] = splitMix64(state);
+            }
+        }
+    }
+    // Each right gets its own key; a set of rights hashes to their XOR
+    std::uint64_t rights[4] = {};
+    for (auto& key : rights) {
+        key = splitMix64(state);
+    }
+    for (int mask = 0; mask < 16; ++mask) {
+        for (int bit = 0; bit < 4; ++bit) {
+            if (mask & (1 << bit)) {
+                keys.castling[mask] ^= rights[bit];
+            }
+        }
+    }
+    for (auto& key : keys.enPassant) {
+        key = splitMix64(state);
+    }
+    keys.blackToMove = splitMix64(state);
+    return keys;
+}
+
+constexpr ZobristKeys ZOBRIST = makeZobristKeys();
+
+PieceType promotionType(Move move) {
+    return static_cast<PieceType>(static_cast<int>(PieceType::KNIGHT) + move.promotionIndex());
+}
+
+// Packed undo state: captured piece type in the low 3 bits, then the
+// castling rights, the en passant column + 1 (0 for none) and, in the high
+// 16 bits, the halfmove clock
+constexpr int UNDO_CASTLING_SHIFT = 3;
+constexpr int UNDO_EN_PASSANT_SHIFT = 7;
+constexpr int UNDO_CLOCK_SHIFT = 16;
+
+// A FEN move counter: digits only, at most maxValue
+bool parseCount(std::string_view text, int maxValue, int& value) {
+    if (text.empty() || text.size() > 6) {
+        return false;
+    }
+    int result = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    if (result > maxValue) {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+char* writeCount(char* out, int value) {
+    char digits[12];
+    int length = 0;
+    do {
+        digits[length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (length > 0) {
+        *out++ = digits[--length];
+    }
+    return out;
+}
+
+// Whether a parsed FEN board could come up in a game: one king and at most
+// 16 pieces and 8 pawns a side, no pawn on the first or last row, and the
+// side that just moved not in check. Anything else can break the limits
+// move generation relies on, e.g. MoveList::CAPACITY.
+bool isPlayablePlacement(const std::array<Piece, 64>& placement, PieceColor side) {
+    Bitboard byType[2][7] = {};
+    Bitboard occupied = 0;
+    for (int square = 0; square < 64; ++square) {
+        const Piece& piece = placement[square];
+        if (!piece.isEmpty()) {
+            byType[colorIndex(piece.color)][static_cast<int>(piece.type)] |= squareBB(square);
+            occupied |= squareBB(square);
+        }
+    }
+
+    for (int color = 0; color < 2; ++color) {
+        const Bitboard* own = byType[color];
+        Bitboard all = 0;
+        for (int type = 1; type < 7; ++type) {
+            all |= own[type];
+        }
+        if (popCount(own[static_cast<int>(PieceType::KING)]) != 1 || popCount(all) > 16 ||
+            popCount(own[static_cast<int>(PieceType::PAWN)]) > 8 ||
+            (own[static_cast<int>(PieceType::PAWN)] & (ROW_0 | ROW_7))) {
+            return false;
+        }
+    }
+
+    // Same test as attackersTo, against the king of the side not to move
+    const Bitboard* mover = byType[colorIndex(side)];
+    int king = lsb(byType[colorIndex(opponentOf(side))][static_cast<int>(PieceType::KING)]);
+    Bitboard queens = mover[static_cast<int>(PieceType::QUEEN)];
+    return ((pawnAttacksFrom(king, side != PieceColor::WHITE) & mover[static_cast<int>(PieceType::PAWN)]) |
+            (knightAttacksFrom(king) & mover[static_cast<int>(PieceType::KNIGHT)]) |
+            (kingAttacksFrom(king) & mover[static_cast<int>(PieceType::KING)]) |
+            (bishopAttacks(king, occupied) & (mover[static_cast<int>(PieceType::BISHOP)] | queens)) |
+            (rookAttacks(king, occupied) & (mover[static_cast<int>(PieceType::ROOK)] | queens))) == 0;
+}
+
+}
+
+Chess::Chess() : currentPlayer(PieceColor::WHITE), positionCache(nullptr) {
+    initSliderAttacks();
+    undoStack.reserve(UNDO_RESERVE);
     resetBoard();
 }
 
+void Chess::clearBoard() {
+    squares.fill(Piece());
+    for (auto& sets : pieceBB) {
+        sets.fill(0);
+    }
+    colorBB.fill(0);
+    occupiedBB = 0;
+    kingSquare.fill(-1);
+    positionKey = 0;
+    pawnKey = 0;
+    materialMg = 0;
+    materialEg = 0;
+    gamePhase = 0;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    keyCount = 0;
+    keyFloor = 0;
+    undoStack.clear();
+    statusCache.invalidate();
+}
+
 void Chess::resetBoard() {
-    // Clear board
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            board[i][j] = Piece();
+    clearBoard();
+    
+    static const PieceType backRank[8] = {
+        PieceType::ROOK, PieceType::KNIGHT, PieceType::BISHOP, PieceType::QUEEN,
+        PieceType::KING, PieceType::BISHOP, PieceType::KNIGHT, PieceType::ROOK
+    };
+    
+    for (int j = 0; j < 8; ++j) {
+        // Setup white pieces (bottom)
+        putPiece(squareOf(7, j), Piece(backRank[j], PieceColor::WHITE));
+        putPiece(squareOf(6, j), Piece(PieceType::PAWN, PieceColor::WHITE));
+        
+        // Setup black pieces (top)
+        putPiece(squareOf(0, j), Piece(backRank[j], PieceColor::BLACK));
+        putPiece(squareOf(1, j), Piece(PieceType::PAWN, PieceColor::BLACK));
+    }
+    
+    currentPlayer = PieceColor::WHITE;
+    castlingRights = WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE;
+    enPassantSquare = -1;
+    positionKey ^= ZOBRIST.castling[castlingRights];
+}
+
+bool Chess::loadFen(std::string_view fen) {
+    CHESS_TIME_CALL(ChessCall::LOAD_FEN);
+    // Split into space-separated fields without copying
+    std::string_view fields[6];
+    int fieldCount = 0;
+    std::size_t pos = 0;
+    while (fieldCount < 6) {
+        pos = fen.find_first_not_of(' ', pos);
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        std::size_t end = fen.find(' ', pos);
+        if (end == std::string_view::npos) {
+            end = fen.size();
         }
+        fields[fieldCount++] = fen.substr(pos, end - pos);
+        pos = end;
+    }
+    if (fieldCount < 2) {
+        return false;
     }
     
-    // Setup white pieces (bottom)
-    board[7][0] = Piece(PieceType::ROOK, PieceColor::WHITE);
-    board[7][1] = Piece(PieceType::KNIGHT, PieceColor::WHITE);
-    board[7][2] = Piece(PieceType::BISHOP, PieceColor::WHITE);
-    board[7][3] = Piece(PieceType::QUEEN, PieceColor::WHITE);
-    board[7][4] = Piece(PieceType::KING, PieceColor::WHITE);
-    board[7][5] = Piece(PieceType::BISHOP, PieceColor::WHITE);
-    board[7][6] = Piece(PieceType::KNIGHT, PieceColor::WHITE);
-    board[7][7] = Piece(PieceType::ROOK, PieceColor::WHITE);
+    // Piece placement, from row 0 (rank 8) down to row 7 (rank 1)
+    std::array<Piece, 64> placement;
+    int row = 0;
+    int col = 0;
+    for (char c : fields[0]) {
+        if (c == '/') {
+            if (col != 8 || ++row > 7) {
+                return false;
+            }
+            col = 0;
+        } else if (c >= '1' && c <= '8') {
+            col += c - '0';
+            if (col > 8) {
+                return false;
+            }
+        } else {
+            PieceColor color = (c >= 'a') ? PieceColor::BLACK : PieceColor::WHITE;
+            PieceType type;
+            switch (c | 0x20) {
+                case 'p': type = PieceType::PAWN; break;
+                case 'n': type = PieceType::KNIGHT; break;
+                case 'b': type = PieceType::BISHOP; break;
+                case 'r': type = PieceType::ROOK; break;
+                case 'q': type = PieceType::QUEEN; break;
+                case 'k': type = PieceType::KING; break;
+                default: return false;
+            }
+            if (col > 7) {
+                return false;
+            }
+            placement[squareOf(row, col++)] = Piece(type, color);
+        }
+    }
+    if (row != 7 || col != 8) {
+        return false;
+    }
     
-    for (int j = 0; j < 8; ++j) {
-        board[6][j] = Piece(PieceType::PAWN, PieceColor::WHITE);
+    PieceColor side;
+    if (fields[1] == "w") {
+        side = PieceColor::WHITE;
+    } else if (fields[1] == "b") {
+        side = PieceColor::BLACK;
+    } else {
+        return false;
+    }
+    if (!isPlayablePlacement(placement, side)) {
+        return false;
     }
     
-    // Setup black pieces (top)
-    board[0][0] = Piece(PieceType::ROOK, PieceColor::BLACK);
-    board[0][1] = Piece(PieceType::KNIGHT, PieceColor::BLACK);
-    board[0][2] = Piece(PieceType::BISHOP, PieceColor::BLACK);
-    board[0][3] = Piece(PieceType::QUEEN, PieceColor::BLACK);
-    board[0][4] = Piece(PieceType::KING, PieceColor::BLACK);
-    board[0][5] = Piece(PieceType::BISHOP, PieceColor::BLACK);
-    board[0][6] = Piece(PieceType::KNIGHT, PieceColor::BLACK);
-    board[0][7] = Piece(PieceType::ROOK, PieceColor::BLACK);
+    int rights = 0;
+    if (fieldCount > 2 && fields[2] != "-") {
+        for (char c : fields[2]) {
+            switch (c) {
+                case 'K': rights |= WHITE_KINGSIDE; break;
+                case 'Q': rights |= WHITE_QUEENSIDE; break;
+                case 'k': rights |= BLACK_KINGSIDE; break;
+                case 'q': rights |= BLACK_QUEENSIDE; break;
+                default: return false;
+            }
+        }
+    }
     
-    for (int j = 0; j < 8; ++j) {
-        board[1][j] = Piece(PieceType::PAWN, PieceColor::BLACK);
+    int passedSquare = -1;
+    if (fieldCount > 3 && fields[3] != "-") {
+        std::string_view ep = fields[3];
+        if (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || (ep[1] != '3' && ep[1] != '6')) {
+            return false;
+        }
+        passedSquare = squareOf('8' - ep[1], ep[0] - 'a');
     }
     
-    currentPlayer = PieceColor::WHITE;
+    // Move counters are optional; kept small enough for writeFen's buffer
+    int clock = 0;
+    int moveNumber = 1;
+    if (fieldCount > 4 && !parseCount(fields[4], 9999, clock)) {
+        return false;
+    }
+    if (fieldCount > 5 && !parseCount(fields[5], 99999, moveNumber)) {
+        return false;
+    }
+    
+    clearBoard();
+    for (int square = 0; square < 64; ++square) {
+        if (!placement[square].isEmpty()) {
+            putPiece(square, placement[square]);
+        }
+    }
+    
+    currentPlayer = side;
+    if (side == PieceColor::BLACK) {
+        positionKey ^= ZOBRIST.blackToMove;
+    }
+    halfmoveClock = clock;
+    fullmoveNumber = moveNumber > 0 ? moveNumber : 1;
+    
+    // Rights whose king or rook is not on its home square are dropped
+    castlingRights = 0;
+    for (int square : {WHITE_KING_HOME, squareOf(7, 0), squareOf(7, 7),
+                       BLACK_KING_HOME, squareOf(0, 0), squareOf(0, 7)}) {
+        PieceType type = (square == WHITE_KING_HOME || square == BLACK_KING_HOME)
+            ? PieceType::KING : PieceType::ROOK;
+        PieceColor color = (rowOf(square) == 7) ? PieceColor::WHITE : PieceColor::BLACK;
+        if (squares[square].type != type || squares[square].color != color) {
+            rights &= castlingKeepMask(square);
+        }
+    }
+    setCastlingRights(rights);
+    
+    // As in makeMove, keep the en passant square only if it can be used
+    enPassantSquare = -1;
+    if (passedSquare >= 0) {
+        bool whiteToMove = side == PieceColor::WHITE;
+        Bitboard capturers = pieceBB[colorIndex(side)][static_cast<int>(PieceType::PAWN)];
+        if (pawnAttacksFrom(passedSquare, !whiteToMove) & capturers) {
+            setEnPassantSquare(passedSquare);
+        }
+    }
+    return true;
+}
+
+int Chess::writeFen(char* out) const {
+    static const char letters[] = ".pnbrqk";
+    char* p = out;
+    for (int row = 0; row < 8; ++row) {
+        int empty = 0;
+        for (int col = 0; col < 8; ++col) {
+            const Piece& piece = squares[squareOf(row, col)];
+            if (piece.isEmpty()) {
+                ++empty;
+                continue;
+            }
+            if (empty) {
+                *p++ = static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            char letter = letters[static_cast<int>(piece.type)];
+            *p++ = piece.color == PieceColor::WHITE ? static_cast<char>(letter - 'a' + 'A') : letter;
+        }
+        if (empty) {
+            *p++ = static_cast<char>('0' + empty);
+        }
+        if (row < 7) {
+            *p++ = '/';
+        }
+    }
+    
+    *p++ = ' ';
+    *p++ = currentPlayer == PieceColor::WHITE ? 'w' : 'b';
+    *p++ = ' ';
+    if (castlingRights == 0) {
+        *p++ = '-';
+    } else {
+        const char flags[] = "KQkq";
+        for (int i = 0; i < 4; ++i) {
+            if (castlingRights & (1 << i)) {
+                *p++ = flags[i];
+            }
+        }
+    }
+    *p++ = ' ';
+    if (enPassantSquare < 0) {
+        *p++ = '-';
+    } else {
+        *p++ = static_cast<char>('a' + colOf(enPassantSquare));
+        *p++ = static_cast<char>('8' - rowOf(enPassantSquare));
+    }
+    
+    *p++ = ' ';
+    p = writeCount(p, halfmoveClock);
+    *p++ = ' ';
+    p = writeCount(p, fullmoveNumber);
+    return static_cast<int>(p - out);
+}
+
+std::string Chess::toFen() const {
+    char buffer[MAX_FEN_LENGTH];
+    return std::string(buffer, static_cast<std::size_t>(writeFen(buffer)));
 }
 
 const Piece& Chess::getPiece(int row, int col) const {
@@ -50,24 +420,81 @@ const Piece& Chess::getPiece(int row, int col) const {
     if (row < 0 || row >= 8 || col < 0 || col >= 8) {
         return emptyPiece;
     }
-    return board[row][col];
+    return squares[squareOf(row, col)];
 }
 
 void Chess::setPiece(int row, int col, const Piece& piece) {
     if (row >= 0 && row < 8 && col >= 0 && col < 8) {
-        board[row][col] = piece;
+        int square = squareOf(row, col);
+        removePiece(square);
+        if (!piece.isEmpty() && piece.color != PieceColor::NONE) {
+            putPiece(square, piece);
+        }
+        
+        // A hand-edited position has no history to take back, and editing a
+        // king or rook home square gives up the rights that depend on it
+        setCastlingRights(castlingRights & castlingKeepMask(square));
+        setEnPassantSquare(-1);
+        halfmoveClock = 0;
+        keyFloor = keyCount;
+        undoStack.clear();
+        statusCache.invalidate();
+    }
+}
+
+void Chess::putPiece(int square, const Piece& piece) {
+    Bitboard bit = squareBB(square);
+    int color = colorIndex(piece.color);
+    squares[square] = piece;
+    pieceBB[color][static_cast<int>(piece.type)] |= bit;
+    colorBB[color] |= bit;
+    occupiedBB |= bit;
+    positionKey ^= ZOBRIST.pieces[color][static_cast<int>(piece.type)][square];
+    materialMg += PIECE_SQUARE.mg[color][static_cast<int>(piece.type)][square];
+    materialEg += PIECE_SQUARE.eg[color][static_cast<int>(piece.type)][square];
+    gamePhase += PHASE_WEIGHTS[static_cast<int>(piece.type)];
+    if (piece.type == PieceType::PAWN) {
+        pawnKey ^= ZOBRIST.pieces[color][static_cast<int>(PieceType::PAWN)][square];
+    } else if (piece.type == PieceType::KING) {
+        kingSquare[color] = square;
+    }
+}
+
+void Chess::removePiece(int square) {
+    const Piece& piece = squares[square];
+    if (piece.isEmpty()) {
+        return;
+    }
+    Bitboard bit = squareBB(square);
+    int color = colorIndex(piece.color);
+    pieceBB[color][static_cast<int>(piece.type)] &= ~bit;
+    colorBB[color] &= ~bit;
+    occupiedBB &= ~bit;
+    positionKey ^= ZOBRIST.pieces[color][static_cast<int>(piece.type)][square];
+    materialMg -= PIECE_SQUARE.mg[color][static_cast<int>(piece.type)][square];
+    materialEg -= PIECE_SQUARE.eg[color][static_cast<int>(piece.type)][square];
+    gamePhase -= PHASE_WEIGHTS[static_cast<int>(piece.type)];
+    if (piece.type == PieceType::PAWN) {
+        pawnKey ^= ZOBRIST.pieces[color][static_cast<int>(PieceType::PAWN)][square];
+    } else if (piece.type == PieceType::KING) {
+        // Positions set up by hand may hold a second king
+        Bitboard kings = pieceBB[color][static_cast<int>(PieceType::KING)];
+        kingSquare[color] = kings ? lsb(kings) : -1;
     }
+    squares[square] = Piece();
 }
 
 bool Chess::isValidMove(int fromRow, int fromCol, int toRow, int toCol) const {
+    CHESS_COUNT(HotPath::IS_VALID_MOVE);
+    CHESS_TIME_CALL(ChessCall::IS_VALID_MOVE);
     // Check bounds
     if (fromRow < 0 || fromRow >= 8 || fromCol < 0 || fromCol >= 8 ||
         toRow < 0 || toRow >= 8 || toCol < 0 || toCol >= 8) {
         return false;
     }
     
-    const Piece& piece = board[fromRow][fromCol];
-    const Piece& targetPiece = board[toRow][toCol];
+    const Piece& piece = getPiece(fromRow, fromCol);
+    const Piece& targetPiece = getPiece(toRow, toCol);
     
     // Check if piece exists and belongs to current player
     if (piece.isEmpty() || piece.color != currentPlayer) {
@@ -84,84 +511,722 @@ bool Chess::isValidMove(int fromRow, int fromCol, int toRow, int toCol) const {
         return false;
     }
     
-    // Simulate the move and check if it leaves the king in check
-    Piece originalPiece = board[fromRow][fromCol];
-    Piece capturedPiece = board[toRow][toCol];
-    board[toRow][toCol] = originalPiece;
-    board[fromRow][fromCol] = Piece();
+    // Move is valid only if king is not in check after it
+    int from = squareOf(fromRow, fromCol);
+    int to = squareOf(toRow, toCol);
+    return (legalTargets(from, moveContext(currentPlayer)) & squareBB(to)) != 0;
+}
+
+bool Chess::isLegal(Move move) const {
+    // Work out the occupancy after the move and look for enemy attackers
+    // on our king, without touching the board itself
+    int from = move.from();
+    int to = move.to();
+    const Piece& piece = squares[from];
+    int us = colorIndex(piece.color);
     
-    // Check if king is in check after this move
-    bool kingInCheck = isKingInCheck(currentPlayer);
+    Bitboard captured = squareBB(to);
+    if (move.flag() == Move::EN_PASSANT) {
+        captured = squareBB(piece.color == PieceColor::WHITE ? to + 8 : to - 8);
+    }
+    Bitboard occupied = (occupiedBB & ~squareBB(from) & ~captured) | squareBB(to);
+    if (move.flag() == Move::KING_CASTLE) {
+        occupied ^= squareBB(to + 1) | squareBB(to - 1);
+    } else if (move.flag() == Move::QUEEN_CASTLE) {
+        occupied ^= squareBB(to - 2) | squareBB(to + 1);
+    }
     
-    // Undo the move
-    board[fromRow][fromCol] = originalPiece;
-    board[toRow][toCol] = capturedPiece;
+    int king = (piece.type == PieceType::KING) ? to : kingSquare[us];
+    if (king < 0) {
+        return true;
+    }
+    Bitboard enemies = colorBB[us ^ 1] & ~captured;
+    return (attackersTo(king, occupied) & enemies) == 0;
+}
+
+int Chess::moveFlag(int from, int to) const {
+    const Piece& piece = squares[from];
+    bool capture = !squares[to].isEmpty();
     
-    // Move is valid only if king is not in check after it
-    return !kingInCheck;
+    if (piece.type == PieceType::PAWN) {
+        if (to == enPassantSquare && colOf(from) != colOf(to)) {
+            return Move::EN_PASSANT;
+        }
+        if (to - from == 16 || from - to == 16) {
+            return Move::DOUBLE_PUSH;
+        }
+    } else if (piece.type == PieceType::KING) {
+        if (to - from == 2) {
+            return Move::KING_CASTLE;
+        }
+        if (from - to == 2) {
+            return Move::QUEEN_CASTLE;
+        }
+    }
+    return capture ? Move::CAPTURE : Move::QUIET;
 }
 
 bool Chess::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
+    CHESS_TIME_CALL(ChessCall::MOVE_PIECE);
     if (!isValidMove(fromRow, fromCol, toRow, toCol)) {
         return false;
     }
     
-    Piece piece = board[fromRow][fromCol];
-    board[toRow][toCol] = piece;
-    board[fromRow][fromCol] = Piece();
+    // A pawn reaching the last row arrives as a pawn; promotePawn finishes the move
+    int from = squareOf(fromRow, fromCol);
+    int to = squareOf(toRow, toCol);
+    makeMove(Move(from, to, moveFlag(from, to)));
+    
+    return true;
+}
+
+void Chess::makeMove(Move move) {
+    CHESS_TIME_CALL(ChessCall::MAKE_MOVE);
+    int from = move.from();
+    int to = move.to();
+    Piece piece = squares[from];
+    
+    UndoInfo undo;
+    undo.move = move;
+    undo.castlingRights = static_cast<std::uint8_t>(castlingRights);
+    undo.enPassantSquare = static_cast<std::int8_t>(enPassantSquare);
+    undo.halfmoveClock = static_cast<std::uint16_t>(halfmoveClock);
+    undo.positionKey = positionKey;
+    pushKey(positionKey);
+    
+    int capturedSquare = to;
+    if (move.flag() == Move::EN_PASSANT) {
+        capturedSquare = (piece.color == PieceColor::WHITE) ? to + 8 : to - 8;
+    }
+    undo.captured = squares[capturedSquare];
+    removePiece(capturedSquare);
+    
+    removePiece(from);
+    putPiece(to, move.isPromotion() ? Piece(promotionType(move), piece.color) : piece);
+    
+    // The rook jumps over the king when castling
+    if (move.flag() == Move::KING_CASTLE) {
+        Piece rook = squares[to + 1];
+        removePiece(to + 1);
+        putPiece(to - 1, rook);
+    } else if (move.flag() == Move::QUEEN_CASTLE) {
+        Piece rook = squares[to - 2];
+        removePiece(to - 2);
+        putPiece(to + 1, rook);
+    }
+    
+    // The en passant square is only recorded when an enemy pawn could use it,
+    // so positions that differ only by an unusable double push hash the same
+    int passedSquare = -1;
+    if (move.flag() == Move::DOUBLE_PUSH) {
+        Bitboard enemyPawns = pieceBB[colorIndex(piece.color) ^ 1][static_cast<int>(PieceType::PAWN)];
+        if (pawnAttacksFrom((from + to) / 2, piece.color == PieceColor::WHITE) & enemyPawns) {
+            passedSquare = (from + to) / 2;
+        }
+    }
+    setEnPassantSquare(passedSquare);
+    setCastlingRights(castlingRights & castlingKeepMask(from) & castlingKeepMask(to));
+    
+    if (piece.type == PieceType::PAWN || !undo.captured.isEmpty()) {
+        halfmoveClock = 0;
+    } else {
+        ++halfmoveClock;
+    }
+    if (piece.color == PieceColor::BLACK) {
+        ++fullmoveNumber;
+    }
     
     // Switch player
-    currentPlayer = (currentPlayer == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+    currentPlayer = opponentOf(currentPlayer);
+    positionKey ^= ZOBRIST.blackToMove;
+    undoStack.push_back(undo);
+    statusCache.invalidate();
+}
+
+void Chess::unmakeMove() {
+    CHESS_TIME_CALL(ChessCall::UNMAKE_MOVE);
+    if (undoStack.empty()) {
+        return;
+    }
     
-    return true;
+    const UndoInfo& undo = undoStack.back();
+    currentPlayer = opponentOf(currentPlayer);
+    castlingRights = undo.castlingRights;
+    enPassantSquare = undo.enPassantSquare;
+    halfmoveClock = undo.halfmoveClock;
+    if (currentPlayer == PieceColor::BLACK) {
+        --fullmoveNumber;
+    }
+    popKey();
+    
+    restorePieces(undo.move, undo.captured);
+    
+    positionKey = undo.positionKey;
+    undoStack.pop_back();
+    statusCache.invalidate();
+}
+
+bool Chess::canUnmakeMove() const {
+    return !undoStack.empty();
+}
+
+Move Chess::lastMove() const {
+    return undoStack.back().move;
+}
+
+std::uint32_t Chess::lastUndoState() const {
+    const UndoInfo& undo = undoStack.back();
+    std::uint32_t enPassant = undo.enPassantSquare >= 0 ? colOf(undo.enPassantSquare) + 1 : 0;
+    return static_cast<std::uint32_t>(undo.captured.type) |
+           (std::uint32_t(undo.castlingRights) << UNDO_CASTLING_SHIFT) |
+           (enPassant << UNDO_EN_PASSANT_SHIFT) |
+           (std::uint32_t(undo.halfmoveClock) << UNDO_CLOCK_SHIFT);
+}
+
+void Chess::unmakeMove(Move move, std::uint32_t undoState) {
+    if (!undoStack.empty() && undoStack.back().move == move) {
+        unmakeMove();
+        return;
+    }
+    
+    // Without the saved key, the key is updated along with each change
+    PieceColor captureColor = currentPlayer;
+    currentPlayer = opponentOf(currentPlayer);
+    positionKey ^= ZOBRIST.blackToMove;
+    halfmoveClock = static_cast<int>(undoState >> UNDO_CLOCK_SHIFT);
+    if (currentPlayer == PieceColor::BLACK) {
+        --fullmoveNumber;
+    }
+    popKey();
+    
+    PieceType captured = static_cast<PieceType>(undoState & 7);
+    restorePieces(move, captured == PieceType::EMPTY ? Piece() : Piece(captured, captureColor));
+    
+    setCastlingRights((undoState >> UNDO_CASTLING_SHIFT) & 15);
+    // The square a double push passed, seen from the side that moves next
+    int enPassant = (undoState >> UNDO_EN_PASSANT_SHIFT) & 15;
+    int passedRow = currentPlayer == PieceColor::WHITE ? 2 : 5;
+    setEnPassantSquare(enPassant > 0 ? squareOf(passedRow, enPassant - 1) : -1);
+    statusCache.invalidate();
+}
+
+// Puts the pieces back as they were before move; the side to move must
+// already be the one that played it
+void Chess::restorePieces(Move move, const Piece& captured) {
+    int from = move.from();
+    int to = move.to();
+    
+    if (move.flag() == Move::KING_CASTLE) {
+        Piece rook = squares[to - 1];
+        removePiece(to - 1);
+        putPiece(to + 1, rook);
+    } else if (move.flag() == Move::QUEEN_CASTLE) {
+        Piece rook = squares[to + 1];
+        removePiece(to + 1);
+        putPiece(to - 2, rook);
+    }
+    
+    Piece piece = squares[to];
+    if (move.isPromotion()) {
+        piece = Piece(PieceType::PAWN, piece.color);
+    }
+    removePiece(to);
+    putPiece(from, piece);
+    
+    if (!captured.isEmpty()) {
+        int capturedSquare = to;
+        if (move.flag() == Move::EN_PASSANT) {
+            capturedSquare = (piece.color == PieceColor::WHITE) ? to + 8 : to - 8;
+        }
+        putPiece(capturedSquare, captured);
+    }
+}
+
+int Chess::getCastlingRights() const {
+    return castlingRights;
+}
+
+int Chess::getEnPassantSquare() const {
+    return enPassantSquare;
+}
+
+int Chess::getHalfmoveClock() const {
+    return halfmoveClock;
+}
+
+int Chess::getFullmoveNumber() const {
+    return fullmoveNumber;
+}
+
+std::uint64_t Chess::getPositionKey() const {
+    return positionKey;
+}
+
+std::uint64_t Chess::getPawnKey() const {
+    return pawnKey;
+}
+
+void Chess::setCastlingRights(int rights) {
+    positionKey ^= ZOBRIST.castling[castlingRights] ^ ZOBRIST.castling[rights];
+    castlingRights = rights;
+}
+
+void Chess::setEnPassantSquare(int square) {
+    if (enPassantSquare >= 0) {
+        positionKey ^= ZOBRIST.enPassant[colOf(enPassantSquare)];
+    }
+    enPassantSquare = square;
+    if (square >= 0) {
+        positionKey ^= ZOBRIST.enPassant[colOf(square)];
+    }
 }
 
 PieceColor Chess::getCurrentPlayer() const {
     return currentPlayer;
 }
 
+const GameStatus& Chess::getStatus() const {
+    CHESS_TIME_CALL(ChessCall::GET_STATUS);
+    return statusCache.get([this]() {
+        GameStatus status;
+        MoveList moves;
+        if (!cachedAnalysis(moves, status.inCheck)) {
+            addAllLegalMoves(currentPlayer, moves);
+            status.inCheck = isKingInCheck(currentPlayer);
+        }
+        status.legalMoveCount = moves.size();
+        for (Move move : moves) {
+            status.moves.targets[move.from()] |= squareBB(move.to());
+            if (move.flag() == Move::EN_PASSANT) {
+                int pawn = (currentPlayer == PieceColor::WHITE) ? move.to() + 8 : move.to() - 8;
+                status.moves.captureTargets |= squareBB(pawn);
+            } else if (move.isCapture()) {
+                status.moves.captureTargets |= squareBB(move.to());
+            }
+        }
+        
+        // Checkmate: in check with no legal moves; stalemate: no legal moves
+        // but not in check
+        status.checkmate = status.inCheck && moves.empty();
+        status.stalemate = !status.inCheck && moves.empty();
+        if (status.stalemate) {
+            status.drawReason = DrawReason::STALEMATE;
+        } else if (!status.checkmate) {
+            // Mate on the hundredth ply still wins
+            if (halfmoveClock >= 100) {
+                status.drawReason = DrawReason::FIFTY_MOVES;
+            } else if (isThreefoldRepetition()) {
+                status.drawReason = DrawReason::REPETITION;
+            } else if (hasInsufficientMaterial()) {
+                status.drawReason = DrawReason::INSUFFICIENT_MATERIAL;
+            }
+        }
+        return status;
+    });
+}
+
+void Chess::pushKey(std::uint64_t key) {
+    keyHistory[keyCount & (KEY_HISTORY_SIZE - 1)] = key;
+    ++keyCount;
+    if (keyCount - keyFloor > KEY_HISTORY_SIZE) {
+        ++keyFloor;
+    }
+}
+
+void Chess::popKey() {
+    --keyCount;
+    // Going back past the oldest key kept leaves no history
+    if (keyFloor > keyCount) {
+        keyFloor = keyCount;
+    }
+}
+
+// Times the current position was seen before, counting up to limit.
+// Positions can only repeat since the last capture or pawn move, so the
+// scan stops there, and only every other ply has the same side to move
+int Chess::earlierOccurrences(int limit) const {
+    int oldest = std::max(keyFloor, keyCount - halfmoveClock);
+    int earlier = 0;
+    for (int ply = keyCount - 2; ply >= oldest && earlier < limit; ply -= 2) {
+        if (keyHistory[ply & (KEY_HISTORY_SIZE - 1)] == positionKey) {
+            ++earlier;
+        }
+    }
+    return earlier;
+}
+
+bool Chess::isRepetition() const {
+    return earlierOccurrences(1) > 0;
+}
+
+bool Chess::isThreefoldRepetition() const {
+    return earlierOccurrences(2) == 2;
+}
+
+// Dead positions recognised from the material alone: bare kings, a single
+// minor piece, or only bishops that all stand on squares of one color
+bool Chess::hasInsufficientMaterial() const {
+    Bitboard majorsAndPawns = 0;
+    Bitboard knights = 0;
+    Bitboard bishops = 0;
+    for (const auto& sets : pieceBB) {
+        majorsAndPawns |= sets[static_cast<int>(PieceType::PAWN)] | sets[static_cast<int>(PieceType::ROOK)] |
+                          sets[static_cast<int>(PieceType::QUEEN)];
+        knights |= sets[static_cast<int>(PieceType::KNIGHT)];
+        bishops |= sets[static_cast<int>(PieceType::BISHOP)];
+    }
+    if (majorsAndPawns) {
+        return false;
+    }
+    if (popCount(knights | bishops) <= 1) {
+        return true;
+    }
+    return !knights && ((bishops & LIGHT_SQUARES) == 0 || (bishops & ~LIGHT_SQUARES) == 0);
+}
+
+const LegalMoveTable& Chess::getLegalMoveTable() const {
+    return getStatus().moves;
+}
+
 bool Chess::isGameOver() const {
-    return isCheckmate() || isStalemate();
+    return getStatus().isOver();
 }
 
 bool Chess::isCheckmate() const {
-    // Current player is in checkmate if:
-    // 1. King is in check
-    // 2. Player has no legal moves
-    return isKingInCheck(currentPlayer) && !hasAnyLegalMove(currentPlayer);
+    return getStatus().checkmate;
 }
 
 bool Chess::isStalemate() const {
-    // Current player is in stalemate if:
-    // 1. King is NOT in check
-    // 2. Player has no legal moves
-    return !isKingInCheck(currentPlayer) && !hasAnyLegalMove(currentPlayer);
+    return getStatus().stalemate;
 }
 
 bool Chess::isCheck() const {
+    // Cheap enough on its own that it does not fill the status cache; the
+    // search asks this at every node
+    if (const GameStatus* status = statusCache.ready()) {
+        return status->inCheck;
+    }
+    
+    MoveList moves;
+    bool inCheck;
+    if (cachedAnalysis(moves, inCheck)) {
+        return inCheck;
+    }
     return isKingInCheck(currentPlayer);
 }
 
-std::vector<std::pair<int, int>> Chess::getValidMoves(int row, int col) const {
-    std::vector<std::pair<int, int>> moves;
+MoveList Chess::getValidMoves(int row, int col) const {
+    CHESS_TIME_CALL(ChessCall::GET_VALID_MOVES);
+    MoveList moves;
+    if (row < 0 || row >= 8 || col < 0 || col >= 8) {
+        return moves;
+    }
     
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (isValidMove(row, col, i, j)) {
-                moves.push_back({i, j});
+    // Only the side to move has valid moves, as in isValidMove
+    int from = squareOf(row, col);
+    if (squares[from].isEmpty() || squares[from].color != currentPlayer) {
+        return moves;
+    }
+    
+    MoveList all;
+    bool inCheck;
+    if (cachedAnalysis(all, inCheck)) {
+        for (Move move : all) {
+            if (move.from() == from) {
+                moves.add(move);
             }
         }
+    } else {
+        addLegalMoves(from, moveContext(currentPlayer), moves);
+    }
+    return moves;
+}
+
+MoveList Chess::generateMoves(PieceColor color) const {
+    CHESS_TIME_CALL(ChessCall::GENERATE_MOVES);
+    MoveList moves;
+    if (color == PieceColor::NONE) {
+        return moves;
+    }
+    
+    bool inCheck;
+    if (color == currentPlayer && cachedAnalysis(moves, inCheck)) {
+        return moves;
     }
     
+    addAllLegalMoves(color, moves);
     return moves;
 }
 
+Move Chess::parseUciMove(std::string_view text) const {
+    if (text.size() < 4 || text.size() > 5 ||
+        text[0] < 'a' || text[0] > 'h' || text[1] < '1' || text[1] > '8' ||
+        text[2] < 'a' || text[2] > 'h' || text[3] < '1' || text[3] > '8') {
+        return Move::none();
+    }
+    
+    int from = squareOf('8' - text[1], text[0] - 'a');
+    int to = squareOf('8' - text[3], text[2] - 'a');
+    int promotion = -1;
+    if (text.size() == 5) {
+        switch (text[4]) {
+            case 'n': promotion = 0; break;
+            case 'b': promotion = 1; break;
+            case 'r': promotion = 2; break;
+            case 'q': promotion = 3; break;
+            default: return Move::none();
+        }
+    }
+    
+    for (Move move : getValidMoves(rowOf(from), colOf(from))) {
+        if (move.to() == to &&
+            (move.isPromotion() ? move.promotionIndex() == promotion : promotion < 0)) {
+            return move;
+        }
+    }
+    return Move::none();
+}
+
+Move Chess::parseSanMove(std::string_view text) const {
+    // Check, mate and annotation marks carry no information here
+    while (!text.empty() && (text.back() == '+' || text.back() == '#' ||
+                             text.back() == '!' || text.back() == '?')) {
+        text.remove_suffix(1);
+    }
+    if (text.size() < 2) {
+        return Move::none();
+    }
+    
+    MoveList moves = generateMoves(currentPlayer);
+    
+    if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0") {
+        int flag = text.size() == 3 ? Move::KING_CASTLE : Move::QUEEN_CASTLE;
+        for (Move move : moves) {
+            if (move.flag() == flag) {
+                return move;
+            }
+        }
+        return Move::none();
+    }
+    
+    PieceType type = PieceType::PAWN;
+    switch (text[0]) {
+        case 'N': type = PieceType::KNIGHT; break;
+        case 'B': type = PieceType::BISHOP; break;
+        case 'R': type = PieceType::ROOK; break;
+        case 'Q': type = PieceType::QUEEN; break;
+        case 'K': type = PieceType::KING; break;
+        default: break;
+    }
+    if (type != PieceType::PAWN) {
+        text.remove_prefix(1);
+    }
+    
+    // Promotion suffix, "e8=Q" or the older "e8Q"
+    int promotion = -1;
+    if (type == PieceType::PAWN && text.size() >= 3) {
+        char before = text[text.size() - 2];
+        if (before == '=' || (before >= '1' && before <= '8')) {
+            switch (text.back()) {
+                case 'N': case 'n': promotion = 0; break;
+                case 'B': case 'b': promotion = 1; break;
+                case 'R': case 'r': promotion = 2; break;
+                case 'Q': case 'q': promotion = 3; break;
+                default: break;
+            }
+        }
+        if (promotion >= 0) {
+            text.remove_suffix(before == '=' ? 2 : 1);
+        }
+    }
+    
+    // What is left is [file][rank][x]<file><rank>
+    if (text.size() < 2) {
+        return Move::none();
+    }
+    char toFile = text[text.size() - 2];
+    char toRank = text[text.size() - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') {
+        return Move::none();
+    }
+    int to = squareOf('8' - toRank, toFile - 'a');
+    text.remove_suffix(2);
+    if (!text.empty() && (text.back() == 'x' || text.back() == ':')) {
+        text.remove_suffix(1);
+    }
+    
+    int fromCol = -1;
+    int fromRow = -1;
+    for (char c : text) {
+        if (c >= 'a' && c <= 'h') {
+            fromCol = c - 'a';
+        } else if (c >= '1' && c <= '8') {
+            fromRow = '8' - c;
+        } else {
+            return Move::none();
+        }
+    }
+    
+    // The move must be the only legal one that fits
+    Move match = Move::none();
+    for (Move move : moves) {
+        if (move.to() != to || squares[move.from()].type != type ||
+            (fromCol >= 0 && move.fromCol() != fromCol) ||
+            (fromRow >= 0 && move.fromRow() != fromRow) ||
+            (move.isPromotion() ? move.promotionIndex() != promotion : promotion >= 0)) {
+            continue;
+        }
+        if (!match.isNone()) {
+            return Move::none();
+        }
+        match = move;
+    }
+    return match;
+}
+
+Move Chess::bestMove(int timeMs, int threads) const {
+    Search search(threads);
+    return search.bestMove(*this, timeMs);
+}
+
+void Chess::setPositionCache(PositionCache* cache) {
+    positionCache = cache;
+}
+
+bool Chess::cachedAnalysis(MoveList& moves, bool& inCheck) const {
+    if (!positionCache) {
+        return false;
+    }
+    
+    PositionCache::Result result;
+    if (!positionCache->probe(positionKey, result)) {
+        addAllLegalMoves(currentPlayer, result.moves);
+        result.inCheck = isKingInCheck(currentPlayer);
+        positionCache->store(positionKey, result);
+    }
+    moves = result.moves;
+    inCheck = result.inCheck;
+    return true;
+}
+
+Chess::MoveContext Chess::moveContext(PieceColor color) const {
+    MoveContext context;
+    context.color = color;
+    context.king = kingSquare[colorIndex(color)];
+    context.checkers = 0;
+    context.checkMask = ~Bitboard(0);
+    context.pinned = 0;
+    if (context.king < 0) {
+        return context;
+    }
+    
+    int us = colorIndex(color);
+    Bitboard enemies = colorBB[us ^ 1];
+    const auto& theirs = pieceBB[us ^ 1];
+    int king = context.king;
+    
+    context.checkers = attackersTo(king, occupiedBB) & enemies;
+    if (context.checkers) {
+        // One checker can be captured or blocked; two leave only king moves
+        context.checkMask = (popCount(context.checkers) == 1)
+            ? context.checkers | betweenBB(king, lsb(context.checkers))
+            : 0;
+    }
+    
+    // Enemy sliders that would hit the king if our own pieces were removed;
+    // a lone own piece between such a slider and the king is pinned
+    Bitboard queens = theirs[static_cast<int>(PieceType::QUEEN)];
+    Bitboard snipers =
+        (rookAttacks(king, enemies) & (theirs[static_cast<int>(PieceType::ROOK)] | queens)) |
+        (bishopAttacks(king, enemies) & (theirs[static_cast<int>(PieceType::BISHOP)] | queens));
+    while (snipers) {
+        Bitboard blockers = betweenBB(king, popLsb(snipers)) & occupiedBB;
+        if (popCount(blockers) == 1) {
+            context.pinned |= blockers & colorBB[us];
+        }
+    }
+    return context;
+}
+
+Bitboard Chess::legalTargets(int from, const MoveContext& context) const {
+    const Piece& piece = squares[from];
+    Bitboard targets = pieceTargets(from);
+    
+    if (piece.type == PieceType::KING) {
+        // The king may not step onto an attacked square. Attacks are looked
+        // up with the king lifted off so it cannot hide behind itself
+        // along the checking line.
+        Bitboard occupied = occupiedBB & ~squareBB(from);
+        Bitboard enemies = colorBB[colorIndex(piece.color) ^ 1];
+        Bitboard legal = 0;
+        while (targets) {
+            int to = popLsb(targets);
+            if (!(attackersTo(to, occupied) & enemies & ~squareBB(to))) {
+                legal |= squareBB(to);
+            }
+        }
+        return legal;
+    }
+    
+    // En passant removes a pawn beside the target, which can uncover a check
+    // along the row or resolve a check by the pawn that just moved; it is
+    // rare enough to keep the exact occupancy test
+    Bitboard enPassant = 0;
+    if (piece.type == PieceType::PAWN && enPassantSquare >= 0 && (targets & squareBB(enPassantSquare)) &&
+        moveFlag(from, enPassantSquare) == Move::EN_PASSANT) {
+        targets &= ~squareBB(enPassantSquare);
+        if (isLegal(Move(from, enPassantSquare, Move::EN_PASSANT))) {
+            enPassant = squareBB(enPassantSquare);
+        }
+    }
+    
+    targets &= context.checkMask;
+    if (context.pinned & squareBB(from)) {
+        targets &= lineBB(context.king, from);
+    }
+    return targets | enPassant;
+}
+
+void Chess::addLegalMoves(int from, const MoveContext& context, MoveList& moves) const {
+    const Piece& piece = squares[from];
+    Bitboard targets = legalTargets(from, context);
+    
+    while (targets) {
+        int to = popLsb(targets);
+        int flag = moveFlag(from, to);
+        
+        // A pawn reaching the last row yields one move per promotion piece
+        if (piece.type == PieceType::PAWN && (rowOf(to) == 0 || rowOf(to) == 7)) {
+            int promotion = (flag == Move::CAPTURE) ? Move::PROMOTION_CAPTURE : Move::PROMOTION;
+            for (int index = 0; index < 4; ++index) {
+                moves.add(Move(from, to, promotion + index));
+            }
+        } else {
+            moves.add(Move(from, to, flag));
+        }
+    }
+}
+
+void Chess::addAllLegalMoves(PieceColor color, MoveList& moves) const {
+    MoveContext context = moveContext(color);
+    Bitboard own = colorBB[colorIndex(color)];
+    
+    // In double check only the king can move
+    if (context.checkMask == 0) {
+        own &= squareBB(context.king);
+    }
+    while (own) {
+        addLegalMoves(popLsb(own), context, moves);
+    }
+}
+
 bool Chess::canPieceMove(int fromRow, int fromCol, int toRow, int toCol) const {
+    CHESS_COUNT(HotPath::CAN_PIECE_MOVE);
     if (fromRow == toRow && fromCol == toCol) {
         return false;
     }
     
-    const Piece& piece = board[fromRow][fromCol];
+    const Piece& piece = squares[squareOf(fromRow, fromCol)];
     
     switch (piece.type) {
         case PieceType::PAWN:
@@ -182,31 +1247,12 @@ bool Chess::canPieceMove(int fromRow, int fromCol, int toRow, int toCol) const {
 }
 
 bool Chess::isPathClear(int fromRow, int fromCol, int toRow, int toCol) const {
-    int rowDir = 0, colDir = 0;
-    
-    if (toRow > fromRow) rowDir = 1;
-    else if (toRow < fromRow) rowDir = -1;
-    
-    if (toCol > fromCol) colDir = 1;
-    else if (toCol < fromCol) colDir = -1;
-    
-    int r = fromRow + rowDir;
-    int c = fromCol + colDir;
-    
-    while (r != toRow || c != toCol) {
-        if (!board[r][c].isEmpty()) {
-            return false;
-        }
-        r += rowDir;
-        c += colDir;
-    }
-    
-    return true;
+    return (betweenBB(squareOf(fromRow, fromCol), squareOf(toRow, toCol)) & occupiedBB) == 0;
 }
 
 bool Chess::canPawnMove(int fromRow, int fromCol, int toRow, int toCol) const {
-    const Piece& piece = board[fromRow][fromCol];
-    const Piece& target = board[toRow][toCol];
+    const Piece& piece = squares[squareOf(fromRow, fromCol)];
+    const Piece& target = squares[squareOf(toRow, toCol)];
     
     int direction = (piece.color == PieceColor::WHITE) ? -1 : 1;
     int startRow = (piece.color == PieceColor::WHITE) ? 6 : 1;
@@ -218,134 +1264,238 @@ bool Chess::canPawnMove(int fromRow, int fromCol, int toRow, int toCol) const {
         }
         // Two squares from start
         if (fromRow == startRow && toRow == fromRow + 2 * direction && 
-            target.isEmpty() && board[fromRow + direction][fromCol].isEmpty()) {
+            target.isEmpty() && squares[squareOf(fromRow + direction, fromCol)].isEmpty()) {
             return true;
         }
     }
     
-    // Capture
-    if (std::abs(toCol - fromCol) == 1 && toRow == fromRow + direction && !target.isEmpty()) {
-        return true;
+    // Capture, including en passant for the side to move
+    if (pawnAttacksFrom(squareOf(fromRow, fromCol), piece.color == PieceColor::WHITE) & squareBB(squareOf(toRow, toCol))) {
+        if (!target.isEmpty()) {
+            return true;
+        }
+        if (piece.color == currentPlayer && squareOf(toRow, toCol) == enPassantSquare) {
+            return true;
+        }
     }
     
     return false;
 }
 
 bool Chess::canKnightMove(int fromRow, int fromCol, int toRow, int toCol) const {
-    int rowDiff = std::abs(toRow - fromRow);
-    int colDiff = std::abs(toCol - fromCol);
-    return (rowDiff == 2 && colDiff == 1) || (rowDiff == 1 && colDiff == 2);
+    return (knightAttacksFrom(squareOf(fromRow, fromCol)) & squareBB(squareOf(toRow, toCol))) != 0;
 }
 
 bool Chess::canBishopMove(int fromRow, int fromCol, int toRow, int toCol) const {
-    if (std::abs(toRow - fromRow) != std::abs(toCol - fromCol)) {
-        return false;
-    }
-    return isPathClear(fromRow, fromCol, toRow, toCol);
+    return (bishopAttacks(squareOf(fromRow, fromCol), occupiedBB) & squareBB(squareOf(toRow, toCol))) != 0;
 }
 
 bool Chess::canRookMove(int fromRow, int fromCol, int toRow, int toCol) const {
-    if (fromRow != toRow && fromCol != toCol) {
-        return false;
-    }
-    return isPathClear(fromRow, fromCol, toRow, toCol);
+    return (rookAttacks(squareOf(fromRow, fromCol), occupiedBB) & squareBB(squareOf(toRow, toCol))) != 0;
 }
 
 bool Chess::canQueenMove(int fromRow, int fromCol, int toRow, int toCol) const {
-    return canBishopMove(fromRow, fromCol, toRow, toCol) || 
-           canRookMove(fromRow, fromCol, toRow, toCol);
+    return (queenAttacks(squareOf(fromRow, fromCol), occupiedBB) & squareBB(squareOf(toRow, toCol))) != 0;
 }
 
 bool Chess::canKingMove(int fromRow, int fromCol, int toRow, int toCol) const {
-    return std::abs(toRow - fromRow) <= 1 && std::abs(toCol - fromCol) <= 1;
+    if (kingAttacksFrom(squareOf(fromRow, fromCol)) & squareBB(squareOf(toRow, toCol))) {
+        return true;
+    }
+    PieceColor color = squares[squareOf(fromRow, fromCol)].color;
+    return (castlingTargets(color) & squareBB(squareOf(toRow, toCol))) != 0;
 }
 
 bool Chess::isKingInCheck(PieceColor color) const {
+    CHESS_COUNT(HotPath::IS_KING_IN_CHECK);
     int kingPos = findKingPosition(color);
     if (kingPos == -1) return false;
     
     int kingRow = kingPos / 8;
     int kingCol = kingPos % 8;
     
-    PieceColor opponent = (color == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
-    return isSquareAttacked(kingRow, kingCol, opponent);
+    return isSquareAttacked(kingRow, kingCol, opponentOf(color));
 }
 
 int Chess::findKingPosition(PieceColor color) const {
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (board[i][j].type == PieceType::KING && board[i][j].color == color) {
-                return i * 8 + j;
-            }
-        }
+    if (color == PieceColor::NONE) {
+        return -1;
+    }
+    return kingSquare[colorIndex(color)];
+}
+
+Bitboard Chess::attackersTo(int row, int col) const {
+    if (row < 0 || row >= 8 || col < 0 || col >= 8) {
+        return 0;
     }
-    return -1;
+    return attackersTo(squareOf(row, col), occupiedBB);
+}
+
+Bitboard Chess::attackersTo(int square, Bitboard occupied) const {
+    // Look outward from the target: a piece attacks it exactly when
+    // the same piece standing on the target would attack that piece
+    const auto& white = pieceBB[0];
+    const auto& black = pieceBB[1];
+    
+    Bitboard knights = white[static_cast<int>(PieceType::KNIGHT)] | black[static_cast<int>(PieceType::KNIGHT)];
+    Bitboard kings = white[static_cast<int>(PieceType::KING)] | black[static_cast<int>(PieceType::KING)];
+    Bitboard queens = white[static_cast<int>(PieceType::QUEEN)] | black[static_cast<int>(PieceType::QUEEN)];
+    Bitboard diagonal = white[static_cast<int>(PieceType::BISHOP)] | black[static_cast<int>(PieceType::BISHOP)] | queens;
+    Bitboard straight = white[static_cast<int>(PieceType::ROOK)] | black[static_cast<int>(PieceType::ROOK)] | queens;
+    
+    return (pawnAttacksFrom(square, true) & black[static_cast<int>(PieceType::PAWN)]) |
+           (pawnAttacksFrom(square, false) & white[static_cast<int>(PieceType::PAWN)]) |
+           (knightAttacksFrom(square) & knights) |
+           (kingAttacksFrom(square) & kings) |
+           (bishopAttacks(square, occupied) & diagonal) |
+           (rookAttacks(square, occupied) & straight);
+}
+
+Bitboard Chess::getPieces(PieceColor color, PieceType type) const {
+    if (color == PieceColor::NONE) {
+        return 0;
+    }
+    if (type == PieceType::EMPTY) {
+        return colorBB[colorIndex(color)];
+    }
+    return pieceBB[colorIndex(color)][static_cast<int>(type)];
 }
 
 bool Chess::isSquareAttacked(int row, int col, PieceColor byColor) const {
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            const Piece& piece = board[i][j];
-            if (!piece.isEmpty() && piece.color == byColor) {
-                if (canPieceMove(i, j, row, col)) {
-                    return true;
-                }
+    CHESS_COUNT(HotPath::IS_SQUARE_ATTACKED);
+    if (byColor == PieceColor::NONE) {
+        return false;
+    }
+    return (attackersTo(squareOf(row, col), occupiedBB) & colorBB[colorIndex(byColor)]) != 0;
+}
+
+Bitboard Chess::pieceTargets(int square) const {
+    const Piece& piece = squares[square];
+    if (piece.isEmpty()) {
+        return 0;
+    }
+    
+    bool white = piece.color == PieceColor::WHITE;
+    Bitboard own = colorBB[colorIndex(piece.color)];
+    Bitboard bit = squareBB(square);
+    
+    switch (piece.type) {
+        case PieceType::PAWN: {
+            Bitboard empty = ~occupiedBB;
+            Bitboard single = (white ? shiftNorth(bit) : shiftSouth(bit)) & empty;
+            Bitboard startRow = white ? (ROW_7 >> 8) : (ROW_0 << 8);
+            Bitboard twice = 0;
+            if (bit & startRow) {
+                twice = (white ? shiftNorth(single) : shiftSouth(single)) & empty;
+            }
+            Bitboard enemy = colorBB[colorIndex(piece.color) ^ 1];
+            if (piece.color == currentPlayer && enPassantSquare >= 0) {
+                enemy |= squareBB(enPassantSquare);
             }
+            return single | twice | (pawnAttacksFrom(square, white) & enemy);
         }
+        case PieceType::KNIGHT:
+            return knightAttacksFrom(square) & ~own;
+        case PieceType::BISHOP:
+            return bishopAttacks(square, occupiedBB) & ~own;
+        case PieceType::ROOK:
+            return rookAttacks(square, occupiedBB) & ~own;
+        case PieceType::QUEEN:
+            return queenAttacks(square, occupiedBB) & ~own;
+        case PieceType::KING:
+            return (kingAttacksFrom(square) & ~own) | castlingTargets(piece.color);
+        default:
+            return 0;
     }
-    return false;
+}
+
+Bitboard Chess::castlingTargets(PieceColor color) const {
+    bool white = color == PieceColor::WHITE;
+    int us = colorIndex(color);
+    int kingHome = white ? WHITE_KING_HOME : BLACK_KING_HOME;
+    int kingside = white ? WHITE_KINGSIDE : BLACK_KINGSIDE;
+    int queenside = white ? WHITE_QUEENSIDE : BLACK_QUEENSIDE;
+    
+    if (!(castlingRights & (kingside | queenside)) || kingSquare[us] != kingHome) {
+        return 0;
+    }
+    
+    // The king may not castle out of or through check; the destination
+    // square is left to the ordinary legality test
+    int row = rowOf(kingHome);
+    PieceColor enemy = opponentOf(color);
+    if (isSquareAttacked(row, 4, enemy)) {
+        return 0;
+    }
+    
+    Bitboard rooks = pieceBB[us][static_cast<int>(PieceType::ROOK)];
+    Bitboard targets = 0;
+    if ((castlingRights & kingside) && (rooks & squareBB(kingHome + 3)) &&
+        !(occupiedBB & (squareBB(kingHome + 1) | squareBB(kingHome + 2))) &&
+        !isSquareAttacked(row, 5, enemy)) {
+        targets |= squareBB(kingHome + 2);
+    }
+    if ((castlingRights & queenside) && (rooks & squareBB(kingHome - 4)) &&
+        !(occupiedBB & (squareBB(kingHome - 1) | squareBB(kingHome - 2) | squareBB(kingHome - 3))) &&
+        !isSquareAttacked(row, 3, enemy)) {
+        targets |= squareBB(kingHome - 2);
+    }
+    return targets;
 }
 
 bool Chess::hasAnyLegalMove(PieceColor color) const {
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            const Piece& piece = board[i][j];
-            if (!piece.isEmpty() && piece.color == color) {
-                // Check all possible moves for this piece
-                for (int toRow = 0; toRow < 8; ++toRow) {
-                    for (int toCol = 0; toCol < 8; ++toCol) {
-                        // Try the move
-                        const Piece& targetPiece = board[toRow][toCol];
-                        
-                        // Check if move is valid
-                        if (!targetPiece.isEmpty() && targetPiece.color == color) {
-                            continue; // Can't capture own piece
-                        }
-                        
-                        if (!canPieceMove(i, j, toRow, toCol)) {
-                            continue;
-                        }
-                        
-                        // Simulate the move
-                        Piece originalPiece = board[i][j];
-                        Piece capturedPiece = board[toRow][toCol];
-                        board[toRow][toCol] = originalPiece;
-                        board[i][j] = Piece();
-                        
-                        // Check if king is still in check after this move
-                        bool kingInCheck = isKingInCheck(color);
-                        
-                        // Undo the move
-                        board[i][j] = originalPiece;
-                        board[toRow][toCol] = capturedPiece;
-                        
-                        // If this move leaves king safe, it's a legal move
-                        if (!kingInCheck) {
-                            return true;
-                        }
-                    }
-                }
-            }
+    CHESS_COUNT(HotPath::HAS_ANY_LEGAL_MOVE);
+    CHESS_TIME_CALL(ChessCall::HAS_ANY_LEGAL_MOVE);
+    if (color == PieceColor::NONE) {
+        return false;
+    }
+    
+    MoveList moves;
+    bool inCheck;
+    if (color == currentPlayer && cachedAnalysis(moves, inCheck)) {
+        return !moves.empty();
+    }
+    
+    // The king first: it is the piece most likely to have a move in the
+    // positions (checks) where this question gets asked
+    MoveContext context = moveContext(color);
+    Bitboard own = colorBB[colorIndex(color)];
+    if (context.king >= 0) {
+        if (legalTargets(context.king, context)) {
+            return true;
+        }
+        own &= ~squareBB(context.king);
+    }
+    if (context.checkMask == 0) {
+        return false;
+    }
+    while (own) {
+        if (legalTargets(popLsb(own), context)) {
+            return true;
         }
     }
     return false;
 }
 
 void Chess::promotePawn(int row, int col, PieceType newType) {
+    CHESS_TIME_CALL(ChessCall::PROMOTE_PAWN);
     if (row >= 0 && row < 8 && col >= 0 && col < 8) {
-        const Piece& piece = board[row][col];
+        int square = squareOf(row, col);
+        Piece piece = squares[square];
         if (!piece.isEmpty() && piece.type == PieceType::PAWN) {
-            board[row][col] = Piece(newType, piece.color);
+            removePiece(square);
+            putPiece(square, Piece(newType, piece.color));
+            statusCache.invalidate();
+            
+            // Turn the pawn move that got here into a promotion so unmakeMove restores the pawn
+            if (!undoStack.empty() && newType >= PieceType::KNIGHT && newType <= PieceType::QUEEN) {
+                UndoInfo& last = undoStack.back();
+                if (last.move.to() == square && !last.move.isPromotion()) {
+                    int flag = last.move.isCapture() ? Move::PROMOTION_CAPTURE : Move::PROMOTION;
+                    flag += static_cast<int>(newType) - static_cast<int>(PieceType::KNIGHT);
+                    last.move = Move(last.move.from(), square, flag);
+                }
+            }
         }
     }
 }
@@ -4,21 +4,25 @@
 #include <QtGui/QMouseEvent>
 #include <QtGui/QScreen>
 #include <QtWidgets/QApplication>
+#include <QtCore/QtMath>
 
 ChessBoard::ChessBoard(QWidget *parent)
     : QWidget(parent), chessGame(nullptr), squareSize(60),
-      selectedRow(-1), selectedCol(-1)
+      selectedRow(-1), selectedCol(-1), inputEnabled(true),
+      cacheSquareSize(0), cachePixelRatio(0)
 {
     setMinimumSize(520, 520);
     setMaximumSize(520, 520);
     setStyleSheet("background-color: #f0f0f0;");
     boardOffset = QPoint(10, 10);
+    shownStates.fill(-1);
 }
 
 void ChessBoard::setChessGame(Chess *game)
 {
     chessGame = game;
-    update();
+    shownStates.fill(-1);
+    refreshSquares();
 }
 
 void ChessBoard::resetBoard()
@@ -28,18 +32,111 @@ void ChessBoard::resetBoard()
         chessGame->resetBoard();
         selectedRow = -1;
         selectedCol = -1;
-        update();
+        refreshSquares();
     }
 }
 
+void ChessBoard::setInputEnabled(bool enabled)
+{
+    inputEnabled = enabled;
+    if (!enabled)
+    {
+        selectedRow = -1;
+        selectedCol = -1;
+        refreshSquares();
+    }
+}
+
+void ChessBoard::refreshSquares()
+{
+    // Invalidate only what changed since the last call; the margin covers
+    // the square outlines, which straddle the edge of each rect
+    std::array<int, 64> states = computeSquareStates();
+    for (int square = 0; square < 64; ++square)
+    {
+        if (states[square] != shownStates[square])
+            update(getSquareRect(rowOf(square), colOf(square)).adjusted(-1, -1, 1, 1));
+    }
+    shownStates = states;
+}
+
 void ChessBoard::paintEvent(QPaintEvent *event)
 {
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
 
-    drawBoard(painter);
-    drawHighlights(painter);
-    drawPieces(painter);
+    ensureRenderCache();
+
+    // The painter is clipped to the dirty region, so only that part of the
+    // cached background is copied
+    painter.drawPixmap(backgroundRect(), boardBackground, boardBackground.rect());
+
+    if (!chessGame)
+        return;
+
+    std::array<int, 64> states = computeSquareStates();
+    const QRegion &dirty = event->region();
+    for (int square = 0; square < 64; ++square)
+    {
+        QRect rect = getSquareRect(rowOf(square), colOf(square));
+        if (!dirty.intersects(rect.adjusted(-1, -1, 1, 1)))
+            continue;
+
+        drawHighlights(painter, rect, states[square]);
+        const Piece &piece = chessGame->getPiece(rowOf(square), colOf(square));
+        if (!piece.isEmpty())
+            painter.drawPixmap(rect, pieceAtlas, atlasCell(piece));
+    }
+}
+
+std::array<int, 64> ChessBoard::computeSquareStates() const
+{
+    std::array<int, 64> states{};
+    if (!chessGame)
+        return states;
+
+    for (int square = 0; square < 64; ++square)
+    {
+        const Piece &piece = chessGame->getPiece(rowOf(square), colOf(square));
+        states[square] = static_cast<int>(piece.type) | static_cast<int>(piece.color) << 4;
+    }
+
+    // King in check (cached, so this is cheap)
+    if (chessGame->getStatus().inCheck)
+    {
+        for (int square = 0; square < 64; ++square)
+        {
+            const Piece &piece = chessGame->getPiece(rowOf(square), colOf(square));
+            if (piece.type == PieceType::KING && piece.color == chessGame->getCurrentPlayer())
+                states[square] |= CHECKED_KING;
+        }
+    }
+
+    const LegalMoveTable &table = chessGame->getLegalMoveTable();
+    if (selectedRow >= 0 && selectedCol >= 0)
+    {
+        int from = squareOf(selectedRow, selectedCol);
+        states[from] |= SELECTED;
+
+        // Valid moves from the table built once per position
+        bool pawn = chessGame->getPiece(selectedRow, selectedCol).type == PieceType::PAWN;
+        Bitboard targets = table.targets[from];
+        while (targets)
+        {
+            int to = popLsb(targets);
+            bool capture = !chessGame->getPiece(rowOf(to), colOf(to)).isEmpty() ||
+                (pawn && to == chessGame->getEnPassantSquare());
+            states[to] |= capture ? CAPTURE_TARGET : MOVE_TARGET;
+        }
+    }
+    else
+    {
+        // Capturable opponent pieces are marked even without a selection
+        Bitboard captures = table.captureTargets;
+        while (captures)
+            states[popLsb(captures)] |= CAPTURABLE;
+    }
+    return states;
 }
 
 void ChessBoard::drawBoard(QPainter &painter)
@@ -59,164 +156,151 @@ void ChessBoard::drawBoard(QPainter &painter)
     }
 }
 
-void ChessBoard::drawHighlights(QPainter &painter)
+void ChessBoard::drawHighlights(QPainter &painter, const QRect &rect, int state)
 {
-    if (!chessGame)
-        return;
+    painter.setPen(Qt::black);
+    painter.setBrush(Qt::NoBrush);
 
     // Highlight king in red if in check
-    if (chessGame->isCheck())
+    if (state & CHECKED_KING)
     {
-        // Find the king's position
-        for (int row = 0; row < 8; ++row)
-        {
-            for (int col = 0; col < 8; ++col)
-            {
-                const Piece &piece = chessGame->getPiece(row, col);
-                if (piece.type == PieceType::KING && piece.color == chessGame->getCurrentPlayer())
-                {
-                    QRect kingRect = getSquareRect(row, col);
-                    painter.fillRect(kingRect, QColor(255, 0, 0, 150));
-                    painter.drawRect(kingRect);
-                }
-            }
-        }
+        painter.fillRect(rect, QColor(255, 0, 0, 150));
+        painter.drawRect(rect);
     }
 
-    if (selectedRow >= 0 && selectedCol >= 0)
+    if (state & SELECTED)
     {
-        QRect selectedRect = getSquareRect(selectedRow, selectedCol);
-        painter.fillRect(selectedRect, QColor(255, 255, 0, 100));
-        painter.drawRect(selectedRect);
+        painter.fillRect(rect, QColor(255, 255, 0, 100));
+        painter.drawRect(rect);
+    }
 
-        // Draw valid moves
-        if (chessGame)
-        {
-            auto validMoves = chessGame->getValidMoves(selectedRow, selectedCol);
-            painter.setBrush(QColor(0, 255, 0, 100));
-            
-            for (const auto &move : validMoves)
-            {
-                QRect moveRect = getSquareRect(move.first, move.second);
-                int centerX = moveRect.center().x();
-                int centerY = moveRect.center().y();
-                
-                // Check if this square has an opponent's piece (capturable)
-                const Piece &targetPiece = chessGame->getPiece(move.first, move.second);
-                if (!targetPiece.isEmpty() && targetPiece.color != chessGame->getCurrentPlayer())
-                {
-                    // Draw larger green dot for capturable pieces
-                    painter.setBrush(QColor(0, 255, 0, 180));
-                    painter.setPen(Qt::green);
-                    painter.drawEllipse(centerX - 8, centerY - 8, 16, 16);
-                }
-                else
-                {
-                    // Draw smaller green dot for empty squares
-                    painter.setBrush(QColor(0, 255, 0, 150));
-                    painter.setPen(Qt::darkGreen);
-                    painter.drawEllipse(centerX - 5, centerY - 5, 10, 10);
-                }
-            }
-        }
+    int centerX = rect.center().x();
+    int centerY = rect.center().y();
+    if (state & CAPTURE_TARGET)
+    {
+        // Draw larger green dot for capturable pieces
+        painter.setBrush(QColor(0, 255, 0, 180));
+        painter.setPen(Qt::green);
+        painter.drawEllipse(centerX - 8, centerY - 8, 16, 16);
     }
-    
-    // Also highlight capturable opponent pieces even without selection
-    if (chessGame && selectedRow < 0 && selectedCol < 0)
+    else if (state & MOVE_TARGET)
     {
-        for (int row = 0; row < 8; ++row)
-        {
-            for (int col = 0; col < 8; ++col)
-            {
-                const Piece &piece = chessGame->getPiece(row, col);
-                // Highlight opponent pieces that can be captured by current player
-                if (!piece.isEmpty() && piece.color != chessGame->getCurrentPlayer())
-                {
-                    // Check if any piece of current player can capture this piece
-                    for (int fromRow = 0; fromRow < 8; ++fromRow)
-                    {
-                        for (int fromCol = 0; fromCol < 8; ++fromCol)
-                        {
-                            const Piece &myPiece = chessGame->getPiece(fromRow, fromCol);
-                            if (!myPiece.isEmpty() && myPiece.color == chessGame->getCurrentPlayer())
-                            {
-                                if (chessGame->isValidMove(fromRow, fromCol, row, col))
-                                {
-                                    // This piece can be captured - draw a small green indicator
-                                    QRect captureRect = getSquareRect(row, col);
-                                    int centerX = captureRect.center().x();
-                                    int centerY = captureRect.center().y();
-                                    painter.setBrush(QColor(0, 200, 0, 120));
-                                    painter.setPen(Qt::darkGreen);
-                                    painter.drawEllipse(centerX - 3, centerY - 3, 6, 6);
-                                    goto next_piece;  // Move to next piece to avoid overlapping dots
-                                }
-                            }
-                        }
-                    }
-                    next_piece:;
-                }
-            }
-        }
+        // Draw smaller green dot for empty squares
+        painter.setBrush(QColor(0, 255, 0, 150));
+        painter.setPen(Qt::darkGreen);
+        painter.drawEllipse(centerX - 5, centerY - 5, 10, 10);
+    }
+    else if (state & CAPTURABLE)
+    {
+        painter.setBrush(QColor(0, 200, 0, 120));
+        painter.setPen(Qt::darkGreen);
+        painter.drawEllipse(centerX - 3, centerY - 3, 6, 6);
     }
 }
 
-void ChessBoard::drawPieces(QPainter &painter)
+void ChessBoard::ensureRenderCache()
 {
-    if (!chessGame)
+    // Text layout is the expensive part of a frame, so it only happens here,
+    // when the square size or the screen's pixel ratio changes
+    qreal pixelRatio = devicePixelRatioF();
+    if (!pieceAtlas.isNull() && cacheSquareSize == squareSize && cachePixelRatio == pixelRatio)
         return;
 
-    QFont font("Arial", 36, QFont::Bold);
-    painter.setFont(font);
+    cacheSquareSize = squareSize;
+    cachePixelRatio = pixelRatio;
 
-    for (int row = 0; row < 8; ++row)
+    // Empty board, drawn once with its outlines
+    QRect area = backgroundRect();
+    boardBackground = QPixmap(qCeil(area.width() * pixelRatio), qCeil(area.height() * pixelRatio));
+    boardBackground.fill(Qt::transparent);
     {
-        for (int col = 0; col < 8; ++col)
+        QPainter backgroundPainter(&boardBackground);
+        backgroundPainter.setRenderHint(QPainter::Antialiasing);
+        backgroundPainter.scale(pixelRatio, pixelRatio);
+        backgroundPainter.translate(-area.topLeft());
+        drawBoard(backgroundPainter);
+    }
+
+    int cell = qCeil(squareSize * pixelRatio);
+    pieceAtlas = QPixmap(6 * cell, 2 * cell);
+    pieceAtlas.fill(Qt::transparent);
+
+    QPainter atlasPainter(&pieceAtlas);
+    atlasPainter.setRenderHint(QPainter::Antialiasing);
+    atlasPainter.setRenderHint(QPainter::TextAntialiasing);
+
+    // 36 pt on the original 60 px squares
+    QFont font("Arial", qMax(1, squareSize * 3 / 5), QFont::Bold);
+    atlasPainter.setFont(font);
+
+    const PieceType types[6] = {PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP,
+                                PieceType::ROOK, PieceType::QUEEN, PieceType::KING};
+    for (PieceColor color : {PieceColor::WHITE, PieceColor::BLACK})
+    {
+        for (PieceType type : types)
         {
-            const Piece &piece = chessGame->getPiece(row, col);
-            if (!piece.isEmpty())
-            {
-                QRect rect = getSquareRect(row, col);
-                QString symbol = getPieceSymbol(piece);
+            Piece piece(type, color);
+            // Draw in logical units; the scale maps the square onto the cell
+            atlasPainter.save();
+            atlasPainter.translate(atlasCell(piece).topLeft());
+            atlasPainter.scale(pixelRatio, pixelRatio);
+            atlasPainter.setClipRect(QRect(0, 0, squareSize, squareSize));
+            renderPieceGlyph(atlasPainter, QRect(0, 0, squareSize, squareSize), piece);
+            atlasPainter.restore();
+        }
+    }
+}
 
-                if (piece.color == PieceColor::BLACK)
-                {
-                    // Black pieces: solid black
-                    painter.setPen(Qt::black);
-                    painter.drawText(rect, Qt::AlignCenter, symbol);
-                }
-                else
+void ChessBoard::renderPieceGlyph(QPainter &painter, const QRect &rect, const Piece &piece) const
+{
+    QString symbol = getPieceSymbol(piece);
+
+    if (piece.color == PieceColor::BLACK)
+    {
+        // Black pieces: solid black
+        painter.setPen(Qt::black);
+        painter.drawText(rect, Qt::AlignCenter, symbol);
+    }
+    else
+    {
+        // White pieces: draw with black outline for contrast
+        painter.setPen(QPen(Qt::black, 2));
+        for (int dx = -2; dx <= 2; ++dx)
+        {
+            for (int dy = -2; dy <= 2; ++dy)
+            {
+                if (dx != 0 || dy != 0)
                 {
-                    // White pieces: draw with black outline for contrast
-                    int centerX = rect.center().x();
-                    int centerY = rect.center().y();
-                    
-                    // Draw black outline (shadow effect)
-                    painter.setPen(QPen(Qt::black, 2));
-                    for (int dx = -2; dx <= 2; ++dx)
-                    {
-                        for (int dy = -2; dy <= 2; ++dy)
-                        {
-                            if (dx != 0 || dy != 0)
-                            {
-                                QRect offsetRect = rect.translated(dx, dy);
-                                painter.drawText(offsetRect, Qt::AlignCenter, symbol);
-                            }
-                        }
-                    }
-                    
-                    // Draw white text on top
-                    painter.setPen(Qt::white);
-                    painter.drawText(rect, Qt::AlignCenter, symbol);
+                    QRect offsetRect = rect.translated(dx, dy);
+                    painter.drawText(offsetRect, Qt::AlignCenter, symbol);
                 }
             }
         }
+
+        // Draw white text on top
+        painter.setPen(Qt::white);
+        painter.drawText(rect, Qt::AlignCenter, symbol);
     }
 }
 
+QRect ChessBoard::atlasCell(const Piece &piece) const
+{
+    // Source rect in the atlas's device pixels
+    int cell = qCeil(cacheSquareSize * cachePixelRatio);
+    int column = static_cast<int>(piece.type) - static_cast<int>(PieceType::PAWN);
+    int row = piece.color == PieceColor::WHITE ? 0 : 1;
+    return QRect(column * cell, row * cell, cell, cell);
+}
+
+QRect ChessBoard::backgroundRect() const
+{
+    // The board plus a pixel around it for the outer outline
+    return QRect(boardOffset.x() - 1, boardOffset.y() - 1, 8 * squareSize + 2, 8 * squareSize + 2);
+}
+
 void ChessBoard::mousePressEvent(QMouseEvent *event)
 {
-    if (!chessGame)
+    if (!chessGame || !inputEnabled)
         return;
 
     int row, col;
@@ -226,7 +310,7 @@ void ChessBoard::mousePressEvent(QMouseEvent *event)
     {
         selectedRow = -1;
         selectedCol = -1;
-        update();
+        refreshSquares();
         return;
     }
 
@@ -252,7 +336,7 @@ void ChessBoard::mousePressEvent(QMouseEvent *event)
                 
                 selectedRow = -1;
                 selectedCol = -1;
-                update();
+                refreshSquares();
                 emit moveCompleted();
                 return;
             }
@@ -271,7 +355,7 @@ void ChessBoard::mousePressEvent(QMouseEvent *event)
         selectedCol = -1;
     }
 
-    update();
+    refreshSquares();
 }
 
 void ChessBoard::getSquareFromPoint(const QPoint &point, int &row, int &col) const
@@ -0,0 +1,279 @@
+#include "Evaluation.h"
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+// Indexed by PieceType
+constexpr int MATERIAL_MG[7] = {0, 82, 337, 365, 477, 1025, 0};
+constexpr int MATERIAL_EG[7] = {0, 94, 281, 297, 512, 936, 0};
+
+// Piece-square tables from White's side, laid out like the board (a8 first).
+// Black uses the same tables mirrored top to bottom.
+constexpr int PAWN_MG[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+constexpr int PAWN_EG[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     60,  60,  60,  60,  60,  60,  60,  60,
+     40,  40,  40,  40,  40,  40,  40,  40,
+     25,  25,  25,  25,  25,  25,  25,  25,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+constexpr int KNIGHT_TABLE[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+constexpr int BISHOP_TABLE[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+constexpr int ROOK_TABLE[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0
+};
+
+constexpr int QUEEN_TABLE[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+// The king hides behind its pawns in the middlegame and walks to the
+// center in the endgame
+constexpr int KING_MG[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20
+};
+
+constexpr int KING_EG[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
+
+constexpr const int* TABLES_MG[7] = {
+    nullptr, PAWN_MG, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_MG
+};
+constexpr const int* TABLES_EG[7] = {
+    nullptr, PAWN_EG, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_EG
+};
+
+constexpr PieceSquareTables makePieceSquareTables() {
+    PieceSquareTables tables{};
+    for (int type = 1; type < 7; ++type) {
+        for (int square = 0; square < 64; ++square) {
+            // Flipping the row mirrors the board for Black
+            int mirrored = square ^ 56;
+            tables.mg[0][type][square] = MATERIAL_MG[type] + TABLES_MG[type][square];
+            tables.eg[0][type][square] = MATERIAL_EG[type] + TABLES_EG[type][square];
+            tables.mg[1][type][square] = -(MATERIAL_MG[type] + TABLES_MG[type][mirrored]);
+            tables.eg[1][type][square] = -(MATERIAL_EG[type] + TABLES_EG[type][mirrored]);
+        }
+    }
+    return tables;
+}
+
+// Mobility per reachable square, counted around a typical number of squares
+// so the term stays near zero for an average piece (indexed by PieceType)
+constexpr int MOBILITY_MG[7] = {0, 0, 4, 5, 2, 1, 0};
+constexpr int MOBILITY_EG[7] = {0, 0, 4, 5, 4, 2, 0};
+constexpr int MOBILITY_BASE[7] = {0, 0, 4, 6, 7, 13, 0};
+
+// Pawn structure
+constexpr int DOUBLED_MG = -10;
+constexpr int DOUBLED_EG = -20;
+constexpr int ISOLATED_MG = -10;
+constexpr int ISOLATED_EG = -15;
+// Passed pawn bonus by rank counted from the pawn's own side
+constexpr int PASSED_MG[8] = {0, 5, 10, 15, 25, 40, 60, 0};
+constexpr int PASSED_EG[8] = {0, 10, 20, 35, 60, 90, 130, 0};
+
+constexpr Bitboard fileBB(int col) {
+    return FILE_A << col;
+}
+
+constexpr Bitboard adjacentFilesBB(int col) {
+    return (col > 0 ? fileBB(col - 1) : 0) | (col < 7 ? fileBB(col + 1) : 0);
+}
+
+// Squares in front of a pawn on its own and the adjacent files, which
+// must be free of enemy pawns for it to be passed
+struct PassedMasks {
+    Bitboard masks[2][64];
+};
+
+constexpr PassedMasks makePassedMasks() {
+    PassedMasks passed{};
+    for (int square = 0; square < 64; ++square) {
+        Bitboard files = fileBB(colOf(square)) | adjacentFilesBB(colOf(square));
+        for (int row = 0; row < 8; ++row) {
+            Bitboard rowBB = ROW_0 << (8 * row);
+            if (row < rowOf(square)) {
+                passed.masks[0][square] |= files & rowBB;
+            } else if (row > rowOf(square)) {
+                passed.masks[1][square] |= files & rowBB;
+            }
+        }
+    }
+    return passed;
+}
+
+constexpr PassedMasks PASSED = makePassedMasks();
+
+struct PawnScore {
+    int mg;
+    int eg;
+};
+
+// Doubled, isolated and passed pawn terms for one side
+PawnScore pawnStructure(Bitboard own, Bitboard enemy, int color) {
+    PawnScore score = {0, 0};
+    for (int col = 0; col < 8; ++col) {
+        int count = popCount(own & fileBB(col));
+        if (count > 1) {
+            score.mg += DOUBLED_MG * (count - 1);
+            score.eg += DOUBLED_EG * (count - 1);
+        }
+        if (count > 0 && !(own & adjacentFilesBB(col))) {
+            score.mg += ISOLATED_MG * count;
+            score.eg += ISOLATED_EG * count;
+        }
+    }
+
+    Bitboard pawns = own;
+    while (pawns) {
+        int square = popLsb(pawns);
+        if (!(PASSED.masks[color][square] & enemy)) {
+            int rank = color == 0 ? 7 - rowOf(square) : rowOf(square);
+            score.mg += PASSED_MG[rank];
+            score.eg += PASSED_EG[rank];
+        }
+    }
+    return score;
+}
+
+// Small per-thread cache of pawn-structure scores keyed by Chess::getPawnKey().
+// Pawn placement repeats across most of a search, so nearly every lookup hits.
+// The all-zero starting entries are correct for the pawnless key 0.
+class PawnTable {
+public:
+    static constexpr int SIZE = 16384;
+
+    PawnScore lookup(std::uint64_t key, Bitboard whitePawns, Bitboard blackPawns) {
+        Entry& entry = entries[key & (SIZE - 1)];
+        if (entry.key != key) {
+            PawnScore white = pawnStructure(whitePawns, blackPawns, 0);
+            PawnScore black = pawnStructure(blackPawns, whitePawns, 1);
+            entry.key = key;
+            entry.score = {white.mg - black.mg, white.eg - black.eg};
+        }
+        return entry.score;
+    }
+
+private:
+    struct Entry {
+        std::uint64_t key = 0;
+        PawnScore score = {0, 0};
+    };
+
+    Entry entries[SIZE];
+};
+
+PawnTable& pawnTable() {
+    // Allocated on first use so threads that never evaluate pay nothing
+    thread_local std::unique_ptr<PawnTable> table;
+    if (!table) {
+        table = std::make_unique<PawnTable>();
+    }
+    return *table;
+}
+
+}
+
+constexpr PieceSquareTables PIECE_SQUARE = makePieceSquareTables();
+
+int Chess::evaluate() const {
+    int mg = materialMg;
+    int eg = materialEg;
+
+    Bitboard whitePawns = pieceBB[0][static_cast<int>(PieceType::PAWN)];
+    Bitboard blackPawns = pieceBB[1][static_cast<int>(PieceType::PAWN)];
+    PawnScore pawns = pawnTable().lookup(pawnKey, whitePawns, blackPawns);
+    mg += pawns.mg;
+    eg += pawns.eg;
+
+    // Mobility: squares not held by own pieces or covered by enemy pawns
+    for (int color = 0; color < 2; ++color) {
+        Bitboard safe = ~colorBB[color] & ~pawnAttacks(color == 0 ? blackPawns : whitePawns, color != 0);
+        int sign = color == 0 ? 1 : -1;
+        for (int type = static_cast<int>(PieceType::KNIGHT); type <= static_cast<int>(PieceType::QUEEN); ++type) {
+            Bitboard pieces = pieceBB[color][type];
+            while (pieces) {
+                int square = popLsb(pieces);
+                Bitboard attacks = 0;
+                switch (static_cast<PieceType>(type)) {
+                    case PieceType::KNIGHT: attacks = knightAttacksFrom(square); break;
+                    case PieceType::BISHOP: attacks = bishopAttacks(square, occupiedBB); break;
+                    case PieceType::ROOK: attacks = rookAttacks(square, occupiedBB); break;
+                    default: attacks = queenAttacks(square, occupiedBB); break;
+                }
+                int count = popCount(attacks & safe) - MOBILITY_BASE[type];
+                mg += sign * MOBILITY_MG[type] * count;
+                eg += sign * MOBILITY_EG[type] * count;
+            }
+        }
+    }
+
+    int phase = std::min(gamePhase, MAX_PHASE);
+    int score = (mg * phase + eg * (MAX_PHASE - phase)) / MAX_PHASE;
+    return currentPlayer == PieceColor::WHITE ? score : -score;
+}
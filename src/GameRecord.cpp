@@ -0,0 +1,124 @@
+#include "GameRecord.h"
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+
+// loadFen costs about as much as this many makeMove/unmakeMove calls
+const int CHECKPOINT_LOAD_COST = 16;
+
+}
+
+void GameRecord::reset(const Chess& start) {
+    plies.clear();
+    checkpoints.clear();
+    current = 0;
+    historyStart = 0;
+    addCheckpoint(start);
+}
+
+void GameRecord::recordLastMove(const Chess& position) {
+    plies.resize(current);
+    int kept = current / CHECKPOINT_INTERVAL + 1;
+    if (static_cast<int>(checkpoints.size()) > kept) {
+        checkpoints.resize(kept);
+    }
+
+    plies.push_back({position.lastMove(), position.lastUndoState()});
+    ++current;
+    if (current % CHECKPOINT_INTERVAL == 0) {
+        addCheckpoint(position);
+    }
+}
+
+void GameRecord::play(Chess& position, Move move) {
+    position.makeMove(move);
+    recordLastMove(position);
+}
+
+bool GameRecord::undo(Chess& position) {
+    if (!canUndo()) {
+        return false;
+    }
+    --current;
+    position.unmakeMove(plies[current].move, plies[current].undoState);
+    if (missesHistory(position)) {
+        restore(position, current);
+    }
+    return true;
+}
+
+bool GameRecord::redo(Chess& position) {
+    if (!canRedo()) {
+        return false;
+    }
+    position.makeMove(plies[current].move);
+    ++current;
+    return true;
+}
+
+bool GameRecord::seek(Chess& position, int ply) {
+    if (ply < 0 || ply > length()) {
+        return false;
+    }
+
+    // Start from a checkpoint when stepping from the current ply would take
+    // longer
+    if (!checkpoints.empty() && std::abs(ply - current) > ply - restorePoint(ply) + CHECKPOINT_LOAD_COST) {
+        restore(position, ply);
+        return true;
+    }
+
+    while (current < ply) {
+        redo(position);
+    }
+    while (current > ply) {
+        --current;
+        position.unmakeMove(plies[current].move, plies[current].undoState);
+    }
+    if (missesHistory(position)) {
+        restore(position, ply);
+    }
+    return true;
+}
+
+std::size_t GameRecord::memoryUsage() const {
+    return plies.capacity() * sizeof(Ply) + checkpoints.capacity() * sizeof(Checkpoint);
+}
+
+void GameRecord::addCheckpoint(const Chess& position) {
+    Checkpoint checkpoint;
+    checkpoint.length = position.writeFen(checkpoint.fen.data());
+    checkpoint.halfmoveClock = position.getHalfmoveClock();
+    checkpoints.push_back(checkpoint);
+}
+
+// Ply of the checkpoint to replay from to reach ply: the last one at or
+// before ply, or an earlier one if the position there has moves since the
+// last capture or pawn move behind it. Positions after ply go back no
+// further than that.
+int GameRecord::restorePoint(int ply) const {
+    int index = ply / CHECKPOINT_INTERVAL;
+    int needed = index * CHECKPOINT_INTERVAL - checkpoints[index].halfmoveClock;
+    while (index > 0 && index * CHECKPOINT_INTERVAL > needed) {
+        --index;
+    }
+    return index * CHECKPOINT_INTERVAL;
+}
+
+void GameRecord::restore(Chess& position, int ply) {
+    int start = restorePoint(ply);
+    const Checkpoint& checkpoint = checkpoints[start / CHECKPOINT_INTERVAL];
+    position.loadFen(std::string_view(checkpoint.fen.data(), checkpoint.length));
+    current = start;
+    historyStart = start;
+    while (current < ply) {
+        redo(position);
+    }
+}
+
+// Whether the position reached by taking moves back is missing positions
+// a repetition could involve; only possible after a checkpoint was loaded
+bool GameRecord::missesHistory(const Chess& position) const {
+    return historyStart > 0 && current - position.getHalfmoveClock() < historyStart;
+}
@@ -0,0 +1,312 @@
+#include "Instrumentation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const char* const HOT_PATH_NAMES[HOT_PATH_COUNT] = {
+    "isValidMove", "canPieceMove", "isSquareAttacked", "isKingInCheck", "hasAnyLegalMove"
+};
+
+const char* const CALL_NAMES[CHESS_CALL_COUNT] = {
+    "loadFen", "isValidMove", "movePiece", "promotePawn", "getStatus",
+    "getValidMoves", "generateMoves", "hasAnyLegalMove", "makeMove", "unmakeMove"
+};
+
+void appendFormat(std::string& out, const char* format, unsigned long long value) {
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), format, value);
+    out.append(text, static_cast<std::size_t>(length));
+}
+
+#ifdef CHESS_INSTRUMENT
+
+struct TraceEvent {
+    ChessCall call;
+    std::uint64_t start;
+    std::uint64_t end;
+};
+
+// Events of one thread, or of the threads that have exited
+struct TraceLog {
+    int threadId = 0;
+    std::vector<TraceEvent> events;
+};
+
+struct ThreadSlot;
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadSlot*> live;
+    InstrumentationStats retired;
+    std::vector<TraceLog> retiredTraces;
+    std::atomic<std::size_t> traceCapacity{0};
+    std::uint64_t traceEpoch = 0;
+    int nextThreadId = 1;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+void addCounters(InstrumentationStats& stats, const Instrumentation::Counters& counters) {
+    for (int i = 0; i < HOT_PATH_COUNT; ++i) {
+        stats.counts[i] += counters.counts[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < CHESS_CALL_COUNT; ++i) {
+        const Instrumentation::Counters::Call& call = counters.calls[i];
+        LatencyHistogram& histogram = stats.calls[i];
+        histogram.calls += call.calls.load(std::memory_order_relaxed);
+        histogram.totalTicks += call.totalTicks.load(std::memory_order_relaxed);
+        histogram.maxTicks = std::max(histogram.maxTicks, call.maxTicks.load(std::memory_order_relaxed));
+        for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+            histogram.buckets[b] += call.buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void clearCounters(Instrumentation::Counters& counters) {
+    for (auto& value : counters.counts) {
+        value.store(0, std::memory_order_relaxed);
+    }
+    for (auto& call : counters.calls) {
+        call.calls.store(0, std::memory_order_relaxed);
+        call.totalTicks.store(0, std::memory_order_relaxed);
+        call.maxTicks.store(0, std::memory_order_relaxed);
+        for (auto& bucket : call.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// A thread's counters and trace; on thread exit both are handed over to
+// the registry so nothing counted is lost. Lock order: the registry, then
+// a slot's traceMutex.
+struct ThreadSlot {
+    Instrumentation::Counters counters;
+    TraceLog trace;
+    std::mutex traceMutex;
+
+    ThreadSlot() {
+        clearCounters(counters);
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        trace.threadId = reg.nextThreadId++;
+        reg.live.push_back(this);
+    }
+
+    ~ThreadSlot() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        addCounters(reg.retired, counters);
+        reg.live.erase(std::find(reg.live.begin(), reg.live.end(), this));
+        if (!trace.events.empty()) {
+            reg.retiredTraces.push_back(std::move(trace));
+        }
+        Instrumentation::threadCounters = nullptr;
+    }
+};
+
+ThreadSlot& threadSlot() {
+    thread_local ThreadSlot slot;
+    return slot;
+}
+
+#endif
+
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const {
+    std::uint64_t target = static_cast<std::uint64_t>(fraction * static_cast<double>(calls));
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen > target || (seen == calls && seen > 0)) {
+            return i == 0 ? 0 : std::uint64_t(1) << i;
+        }
+    }
+    return 0;
+}
+
+const char* Instrumentation::name(HotPath path) {
+    return HOT_PATH_NAMES[static_cast<int>(path)];
+}
+
+const char* Instrumentation::name(ChessCall call) {
+    return CALL_NAMES[static_cast<int>(call)];
+}
+
+std::string Instrumentation::toJson(const InstrumentationStats& stats) {
+    std::string out = "{\"enabled\":";
+    out += stats.enabled ? "true" : "false";
+    out += ",\"tickUnit\":\"";
+    out += stats.tickUnit;
+    out += "\",\"counters\":{";
+    for (int i = 0; i < HOT_PATH_COUNT; ++i) {
+        out += i > 0 ? ",\"" : "\"";
+        out += HOT_PATH_NAMES[i];
+        appendFormat(out, "\":%llu", stats.counts[i]);
+    }
+    out += "},\"calls\":{";
+    for (int i = 0; i < CHESS_CALL_COUNT; ++i) {
+        const LatencyHistogram& histogram = stats.calls[i];
+        out += i > 0 ? ",\"" : "\"";
+        out += CALL_NAMES[i];
+        appendFormat(out, "\":{\"calls\":%llu", histogram.calls);
+        appendFormat(out, ",\"totalTicks\":%llu", histogram.totalTicks);
+        appendFormat(out, ",\"meanTicks\":%llu", histogram.calls > 0 ? histogram.totalTicks / histogram.calls : 0);
+        appendFormat(out, ",\"maxTicks\":%llu", histogram.maxTicks);
+        appendFormat(out, ",\"p50\":%llu", histogram.percentile(0.5));
+        appendFormat(out, ",\"p90\":%llu", histogram.percentile(0.9));
+        appendFormat(out, ",\"p99\":%llu", histogram.percentile(0.99));
+        // Trailing empty buckets are left out
+        int used = LatencyHistogram::BUCKETS;
+        while (used > 0 && histogram.buckets[used - 1] == 0) {
+            --used;
+        }
+        out += ",\"histogram\":[";
+        for (int b = 0; b < used; ++b) {
+            appendFormat(out, b > 0 ? ",%llu" : "%llu", histogram.buckets[b]);
+        }
+        out += "]}";
+    }
+    out += "}}";
+    return out;
+}
+
+#ifdef CHESS_INSTRUMENT
+
+bool Instrumentation::enabled() {
+    return true;
+}
+
+Instrumentation::Counters& Instrumentation::registerThread() {
+    threadCounters = &threadSlot().counters;
+    return *threadCounters;
+}
+
+std::uint64_t Instrumentation::traceClock() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Instrumentation::addTraceEvent(ChessCall call, std::uint64_t start, std::uint64_t end) {
+    ThreadSlot& slot = threadSlot();
+    std::size_t capacity = registry().traceCapacity.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(slot.traceMutex);
+    if (slot.trace.events.size() < capacity) {
+        slot.trace.events.push_back({call, start, end});
+    }
+}
+
+InstrumentationStats Instrumentation::collect() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    InstrumentationStats stats = reg.retired;
+    stats.enabled = true;
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    stats.tickUnit = "cycles";
+#endif
+    for (const ThreadSlot* slot : reg.live) {
+        addCounters(stats, slot->counters);
+    }
+    return stats;
+}
+
+void Instrumentation::reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.retired = InstrumentationStats();
+    for (ThreadSlot* slot : reg.live) {
+        clearCounters(slot->counters);
+    }
+}
+
+void Instrumentation::startTrace(std::size_t maxEvents) {
+    Registry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.traceCapacity = maxEvents;
+        // Timestamps count from the first start after a clear
+        if (reg.traceEpoch == 0) {
+            reg.traceEpoch = traceClock();
+        }
+    }
+    tracing.store(true, std::memory_order_relaxed);
+}
+
+void Instrumentation::stopTrace() {
+    tracing.store(false, std::memory_order_relaxed);
+}
+
+void Instrumentation::clearTrace() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.traceEpoch = 0;
+    reg.retiredTraces.clear();
+    for (ThreadSlot* slot : reg.live) {
+        std::lock_guard<std::mutex> traceLock(slot->traceMutex);
+        slot->trace.events.clear();
+    }
+}
+
+std::string Instrumentation::chromeTrace() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::string out = "{\"traceEvents\":[";
+    bool first = true;
+    auto append = [&](const TraceLog& trace) {
+        for (const TraceEvent& event : trace.events) {
+            out += first ? "{\"name\":\"" : ",{\"name\":\"";
+            first = false;
+            out += CALL_NAMES[static_cast<int>(event.call)];
+            out += "\",\"cat\":\"chess\",\"ph\":\"X\",\"pid\":1";
+            appendFormat(out, ",\"tid\":%llu", static_cast<unsigned long long>(trace.threadId));
+            // Microseconds, to the nanosecond
+            std::uint64_t start = event.start - reg.traceEpoch;
+            std::uint64_t duration = event.end - event.start;
+            appendFormat(out, ",\"ts\":%llu", start / 1000);
+            appendFormat(out, ".%03llu", start % 1000);
+            appendFormat(out, ",\"dur\":%llu", duration / 1000);
+            appendFormat(out, ".%03llu}", duration % 1000);
+        }
+    };
+    for (const TraceLog& trace : reg.retiredTraces) {
+        append(trace);
+    }
+    for (ThreadSlot* slot : reg.live) {
+        std::lock_guard<std::mutex> traceLock(slot->traceMutex);
+        append(slot->trace);
+    }
+    out += "],\"displayTimeUnit\":\"ns\"}";
+    return out;
+}
+
+#else
+
+bool Instrumentation::enabled() {
+    return false;
+}
+
+InstrumentationStats Instrumentation::collect() {
+    return InstrumentationStats();
+}
+
+void Instrumentation::reset() {}
+
+void Instrumentation::startTrace(std::size_t) {}
+
+void Instrumentation::stopTrace() {}
+
+void Instrumentation::clearTrace() {}
+
+std::string Instrumentation::chromeTrace() {
+    return "{\"traceEvents\":[],\"displayTimeUnit\":\"ns\"}";
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "LargePageBuffer.h"
+#include <cstring>
+#include <new>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr std::size_t CACHE_LINE = 64;
+constexpr std::size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+}
+
+LargePageBuffer::LargePageBuffer(std::size_t bytes, bool hugePages) {
+    allocate(bytes, hugePages);
+}
+
+LargePageBuffer::~LargePageBuffer() {
+    release();
+}
+
+LargePageBuffer::LargePageBuffer(LargePageBuffer&& other) noexcept
+    : memory(std::exchange(other.memory, nullptr)),
+      bytes(std::exchange(other.bytes, 0)),
+      hugePages(std::exchange(other.hugePages, false)),
+      mapped(std::exchange(other.mapped, false)) {}
+
+LargePageBuffer& LargePageBuffer::operator=(LargePageBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        memory = std::exchange(other.memory, nullptr);
+        bytes = std::exchange(other.bytes, 0);
+        hugePages = std::exchange(other.hugePages, false);
+        mapped = std::exchange(other.mapped, false);
+    }
+    return *this;
+}
+
+void LargePageBuffer::allocate(std::size_t size, bool wantHugePages) {
+    release();
+    if (size == 0) {
+        return;
+    }
+
+    if (wantHugePages) {
+        // Round up so the whole block can be backed by huge pages
+        std::size_t rounded = (size + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+#if defined(_WIN32)
+        SIZE_T largePage = GetLargePageMinimum();
+        if (largePage > 0) {
+            rounded = (size + largePage - 1) / largePage * largePage;
+            memory = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            hugePages = memory != nullptr;
+        }
+        if (!memory) {
+            memory = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        }
+        mapped = memory != nullptr;
+#elif defined(__linux__)
+        void* block = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block != MAP_FAILED) {
+            memory = block;
+            mapped = true;
+#ifdef MADV_HUGEPAGE
+            // Transparent huge pages; the kernel may still decline
+            hugePages = madvise(block, rounded, MADV_HUGEPAGE) == 0;
+#endif
+        }
+#endif
+        if (mapped) {
+            bytes = rounded;
+            return;
+        }
+    }
+
+    memory = ::operator new(size, std::align_val_t(CACHE_LINE));
+    std::memset(memory, 0, size);
+    bytes = size;
+}
+
+void LargePageBuffer::release() {
+    if (!memory) {
+        return;
+    }
+    if (mapped) {
+#if defined(_WIN32)
+        VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(__linux__)
+        munmap(memory, bytes);
+#endif
+    } else {
+        ::operator delete(memory, std::align_val_t(CACHE_LINE));
+    }
+    memory = nullptr;
+    bytes = 0;
+    hugePages = false;
+    mapped = false;
+}
@@ -7,16 +7,58 @@
 #include <QWidget>
 #include <QDialog>
 #include <QMessageBox>
+#include <QCoreApplication>
+#include <QDir>
+#include <QRandomGenerator>
+#include <QStringList>
+
+namespace
+{
+// The computer plays Black and thinks for this long per move
+const PieceColor COMPUTER_COLOR = PieceColor::BLACK;
+const int COMPUTER_THINK_MS = 1000;
+
+// Opening book files, looked for next to the executable
+const char *const BOOK_FILE = "book.bin";
+const char *const BOOK_KEYS_FILE = "polyglot_randoms.txt";
+
+// Directory next to the executable holding tables made by tools/tbgen
+const char *const TABLEBASE_DIR = "tablebases";
+
+QString drawTitle(DrawReason reason)
+{
+    switch (reason)
+    {
+    case DrawReason::FIFTY_MOVES: return "FIFTY-MOVE RULE!";
+    case DrawReason::REPETITION: return "THREEFOLD REPETITION!";
+    case DrawReason::INSUFFICIENT_MATERIAL: return "INSUFFICIENT MATERIAL!";
+    default: return "STALEMATE!";
+    }
+}
+}
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), promotionRow(-1), promotionCol(-1)
+    : QMainWindow(parent), promotionRow(-1), promotionCol(-1),
+      backButton(nullptr), forwardButton(nullptr), computerButton(nullptr),
+      vsComputer(false), engineThread(nullptr), engineMove(Move::none()),
+      engineGeneration(0), bookLabel(nullptr), tablebaseLabel(nullptr)
 {
     setWindowTitle("Chess Game - 2 Player");
     setGeometry(100, 100, 900, 800);
 
     chessGame = new Chess();
+    engine.setThreads(QThread::idealThreadCount());
     boardWidget = new ChessBoard(this);
     boardWidget->setChessGame(chessGame);
+    history.reset(*chessGame);
+
+    // Mapped, not read, so even a large book opens instantly
+    QDir appDir(QCoreApplication::applicationDirPath());
+    book.open(appDir.filePath(BOOK_FILE).toStdString(), appDir.filePath(BOOK_KEYS_FILE).toStdString());
+
+    QDir tablebaseDir(appDir.filePath(TABLEBASE_DIR));
+    for (const QString &file : tablebaseDir.entryList(QStringList() << "*.ctb", QDir::Files))
+        tablebase.addTable(tablebaseDir.filePath(file).toStdString());
 
     setupUI();
     updateStatus();
@@ -24,6 +66,7 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    stopEngine();
 }
 
 void MainWindow::setupUI()
@@ -54,6 +97,23 @@ void MainWindow::setupUI()
     );
     connect(resetButton, &QPushButton::clicked, this, &MainWindow::resetGame);
 
+    backButton = new QPushButton("◀ Back", this);
+    backButton->setMinimumSize(100, 45);
+    backButton->setStyleSheet(resetButton->styleSheet());
+    backButton->setShortcut(QKeySequence(Qt::Key_Left));
+    connect(backButton, &QPushButton::clicked, this, &MainWindow::goBack);
+
+    forwardButton = new QPushButton("Forward ▶", this);
+    forwardButton->setMinimumSize(100, 45);
+    forwardButton->setStyleSheet(resetButton->styleSheet());
+    forwardButton->setShortcut(QKeySequence(Qt::Key_Right));
+    connect(forwardButton, &QPushButton::clicked, this, &MainWindow::goForward);
+
+    computerButton = new QPushButton("vs Computer: Off", this);
+    computerButton->setMinimumSize(160, 45);
+    computerButton->setStyleSheet(resetButton->styleSheet());
+    connect(computerButton, &QPushButton::clicked, this, &MainWindow::toggleComputerOpponent);
+
     turnIndicatorLabel = new QLabel("⚪ White's Turn", this);
     turnIndicatorLabel->setMinimumSize(200, 45);
     turnIndicatorLabel->setAlignment(Qt::AlignCenter);
@@ -68,6 +128,9 @@ void MainWindow::setupUI()
     );
 
     topLayout->addWidget(resetButton);
+    topLayout->addWidget(backButton);
+    topLayout->addWidget(forwardButton);
+    topLayout->addWidget(computerButton);
     topLayout->addStretch();
     topLayout->addWidget(turnIndicatorLabel);
 
@@ -101,22 +164,217 @@ void MainWindow::setupUI()
     mainLayout->addWidget(boardContainer, 1);
 
     // Connect board signals
-    connect(boardWidget, &ChessBoard::moveCompleted, this, &MainWindow::updateStatus);
+    connect(boardWidget, &ChessBoard::moveCompleted, this, &MainWindow::handleMoveCompleted);
     connect(boardWidget, &ChessBoard::promotionNeeded, this, &MainWindow::handlePromotion);
 
     centralWidget->setLayout(mainLayout);
     setCentralWidget(centralWidget);
+
+    bookLabel = new QLabel(this);
+    bookLabel->setVisible(book.isOpen());
+    statusBar()->addPermanentWidget(bookLabel);
+
+    tablebaseLabel = new QLabel(this);
+    tablebaseLabel->setVisible(false);
+    statusBar()->addPermanentWidget(tablebaseLabel);
 }
 
 void MainWindow::resetGame()
 {
+    stopEngine();
     boardWidget->resetBoard();
+    history.reset(*chessGame);
+    statusBar()->clearMessage();
+    updateStatus();
+    startEngineIfNeeded();
+}
+
+void MainWindow::handleMoveCompleted()
+{
+    history.recordLastMove(*chessGame);
+    updateStatus();
+    startEngineIfNeeded();
+}
+
+void MainWindow::goBack()
+{
+    stopEngine();
+    if (history.undo(*chessGame))
+        showHistoryPosition();
+}
+
+void MainWindow::goForward()
+{
+    stopEngine();
+    if (history.redo(*chessGame))
+        showHistoryPosition();
+}
+
+// The computer is not restarted here, so the user can look through the game
+// while it is their opponent; playing a move from here continues the game
+// and drops the moves after it
+void MainWindow::showHistoryPosition()
+{
+    boardWidget->refreshSquares();
+    statusBar()->showMessage(QString("Move %1 of %2").arg(history.ply()).arg(history.length()));
+    updateStatus();
+}
+
+void MainWindow::toggleComputerOpponent()
+{
+    vsComputer = !vsComputer;
+    computerButton->setText(vsComputer ? "vs Computer: On" : "vs Computer: Off");
+
+    if (vsComputer)
+    {
+        startEngineIfNeeded();
+    }
+    else
+    {
+        stopEngine();
+        statusBar()->clearMessage();
+    }
+}
+
+void MainWindow::startEngineIfNeeded()
+{
+    if (!vsComputer || engineThread || chessGame->getCurrentPlayer() != COMPUTER_COLOR ||
+        chessGame->isGameOver())
+        return;
+
+    // Play from the book while it has an answer
+    Move bookMove = book.pick(*chessGame, QRandomGenerator::global()->generate64());
+    if (!bookMove.isNone())
+    {
+        statusBar()->showMessage("Computer: book move " + QString::fromStdString(bookMove.toUci()));
+        playComputerMove(bookMove);
+        return;
+    }
+
+    boardWidget->setInputEnabled(false);
+    statusBar()->showMessage("Computer is thinking...");
+
+    // The search runs on a copy, so the board can still be painted meanwhile
+    Chess snapshot = *chessGame;
+    int generation = ++engineGeneration;
+    // So that stopEngine() right after this is not undone by the worker
+    engine.prepare();
+
+    engineThread = QThread::create([this, snapshot, generation]() {
+        engineMove = engine.bestMove(snapshot, COMPUTER_THINK_MS, Search::MAX_PLY,
+            [this, generation](const SearchInfo &info) {
+                QMetaObject::invokeMethod(this, [this, generation, info]() {
+                    if (generation == engineGeneration)
+                        showEngineInfo(info);
+                }, Qt::QueuedConnection);
+            });
+    });
+    connect(engineThread, &QThread::finished, this, [this, generation]() {
+        applyEngineMove(generation);
+    });
+    engineThread->start();
+}
+
+void MainWindow::stopEngine()
+{
+    if (!engineThread)
+        return;
+
+    // Results of a cancelled search are discarded by the generation check
+    ++engineGeneration;
+    engine.stop();
+    engineThread->wait();
+    engineThread->deleteLater();
+    engineThread = nullptr;
+    boardWidget->setInputEnabled(true);
+}
+
+void MainWindow::applyEngineMove(int generation)
+{
+    if (generation != engineGeneration)
+        return;
+
+    engineThread->deleteLater();
+    engineThread = nullptr;
+    boardWidget->setInputEnabled(true);
+
+    if (!engineMove.isNone())
+        playComputerMove(engineMove);
+}
+
+void MainWindow::playComputerMove(Move move)
+{
+    chessGame->movePiece(move.fromRow(), move.fromCol(), move.toRow(), move.toCol());
+    if (move.isPromotion())
+    {
+        static const PieceType promotions[] = {
+            PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN
+        };
+        chessGame->promotePawn(move.toRow(), move.toCol(), promotions[move.promotionIndex()]);
+    }
+    history.recordLastMove(*chessGame);
+    boardWidget->refreshSquares();
     updateStatus();
 }
 
+void MainWindow::showEngineInfo(const SearchInfo &info)
+{
+    statusBar()->showMessage(QString("Computer: depth %1, %2 nodes, %3 kN/s, %4 ms to depth")
+        .arg(info.depth)
+        .arg(info.nodes)
+        .arg(info.nodesPerSecond() / 1000)
+        .arg(info.elapsedMs));
+}
+
+void MainWindow::showBookMoves()
+{
+    if (!book.isOpen())
+        return;
+
+    std::vector<BookMove> moves = book.lookup(*chessGame);
+    int total = 0;
+    for (const BookMove &entry : moves)
+        total += entry.weight;
+
+    QStringList parts;
+    for (const BookMove &entry : moves)
+    {
+        int percent = total > 0 ? entry.weight * 100 / total : 0;
+        parts << QString("%1 %2%").arg(QString::fromStdString(entry.move.toUci())).arg(percent);
+    }
+    bookLabel->setText(parts.isEmpty() ? "Out of book" : "Book: " + parts.join(", "));
+}
+
+void MainWindow::showTablebaseResult()
+{
+    TablebaseResult result;
+    bool known = !chessGame->isGameOver() && tablebase.probe(*chessGame, result);
+    tablebaseLabel->setVisible(known);
+    if (!known)
+        return;
+
+    if (result.outcome == TablebaseResult::DRAW)
+    {
+        tablebaseLabel->setText("Tablebase: draw");
+        return;
+    }
+
+    bool whiteToMove = chessGame->getCurrentPlayer() == PieceColor::WHITE;
+    bool whiteWins = (result.outcome == TablebaseResult::WIN) == whiteToMove;
+    tablebaseLabel->setText(QString("Tablebase: %1 mates in %2")
+        .arg(whiteWins ? "White" : "Black")
+        .arg((result.pliesToMate + 1) / 2));
+}
+
 void MainWindow::updateStatus()
 {
-    if (chessGame->isCheckmate())
+    const GameStatus &status = chessGame->getStatus();
+    backButton->setEnabled(history.canUndo());
+    forwardButton->setEnabled(history.canRedo());
+    showBookMoves();
+    showTablebaseResult();
+
+    if (status.checkmate)
     {
         QString winner = (chessGame->getCurrentPlayer() == PieceColor::WHITE) 
             ? "BLACK" : "WHITE";
@@ -137,13 +395,13 @@ void MainWindow::updateStatus()
             "}"
         );
     }
-    else if (chessGame->isStalemate())
+    else if (status.drawReason != DrawReason::NONE)
     {
-        // Show large stalemate message on top
-        statusLabel->setText("🏁 STALEMATE!\nDRAW! 🏁");
+        // Show large draw message on top
+        statusLabel->setText("🏁 " + drawTitle(status.drawReason) + "\nDRAW! 🏁");
         statusLabel->setVisible(true);
         
-        // Update turn indicator with stalemate style
+        // Update turn indicator with draw style
         turnIndicatorLabel->setText("GAME OVER");
         turnIndicatorLabel->setStyleSheet(
             "QLabel { "
@@ -188,7 +446,7 @@ void MainWindow::updateStatus()
         }
 
         // Update check status
-        if (chessGame->isCheck())
+        if (status.inCheck)
         {
             turnIndicatorLabel->setText(
                 (chessGame->getCurrentPlayer() == PieceColor::WHITE)
@@ -223,7 +481,7 @@ void MainWindow::handlePromotion(int row, int col)
     );
     connect(knightBtn, &QPushButton::clicked, [this, row, col, &promotionDialog]() {
         chessGame->promotePawn(row, col, PieceType::KNIGHT);
-        boardWidget->update();
+        boardWidget->refreshSquares();
         updateStatus();
         promotionDialog.accept();
     });
@@ -238,7 +496,7 @@ void MainWindow::handlePromotion(int row, int col)
     );
     connect(bishopBtn, &QPushButton::clicked, [this, row, col, &promotionDialog]() {
         chessGame->promotePawn(row, col, PieceType::BISHOP);
-        boardWidget->update();
+        boardWidget->refreshSquares();
         updateStatus();
         promotionDialog.accept();
     });
@@ -253,7 +511,7 @@ void MainWindow::handlePromotion(int row, int col)
     );
     connect(rookBtn, &QPushButton::clicked, [this, row, col, &promotionDialog]() {
         chessGame->promotePawn(row, col, PieceType::ROOK);
-        boardWidget->update();
+        boardWidget->refreshSquares();
         updateStatus();
         promotionDialog.accept();
     });
@@ -268,7 +526,7 @@ void MainWindow::handlePromotion(int row, int col)
     );
     connect(queenBtn, &QPushButton::clicked, [this, row, col, &promotionDialog]() {
         chessGame->promotePawn(row, col, PieceType::QUEEN);
-        boardWidget->update();
+        boardWidget->refreshSquares();
         updateStatus();
         promotionDialog.accept();
     });
@@ -0,0 +1,105 @@
+#include "MappedFile.h"
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path, Access access) {
+    open(path, access);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : memory(std::exchange(other.memory, nullptr)),
+      bytes(std::exchange(other.bytes, 0)),
+      opened(std::exchange(other.opened, false)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        memory = std::exchange(other.memory, nullptr);
+        bytes = std::exchange(other.bytes, 0);
+        opened = std::exchange(other.opened, false);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+#if defined(_WIN32)
+    DWORD hint = access == Access::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              hint, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+    if (fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            memory = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            // The view keeps the mapping alive
+            CloseHandle(mapping);
+        }
+        if (!memory) {
+            CloseHandle(file);
+            return false;
+        }
+        bytes = static_cast<std::size_t>(fileSize.QuadPart);
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (info.st_size > 0) {
+        void* block = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (block == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+#if defined(MADV_SEQUENTIAL) && defined(MADV_RANDOM)
+        madvise(block, static_cast<std::size_t>(info.st_size),
+                access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+#endif
+        memory = static_cast<const char*>(block);
+        bytes = static_cast<std::size_t>(info.st_size);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+#endif
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (memory) {
+#if defined(_WIN32)
+        UnmapViewOfFile(memory);
+#else
+        munmap(const_cast<char*>(memory), bytes);
+#endif
+    }
+    memory = nullptr;
+    bytes = 0;
+    opened = false;
+}
@@ -0,0 +1,89 @@
+#include "Perft.h"
+#include <algorithm>
+#include <new>
+#include <thread>
+
+PerftTable::PerftTable(std::size_t megabytes, bool hugePages) {
+    entries = std::max<std::size_t>(1, megabytes * 1024 * 1024 / sizeof(Entry));
+    memory.allocate(entries * sizeof(Entry), hugePages);
+    table = new (memory.data()) Entry[entries];
+}
+
+bool PerftTable::probe(std::uint64_t key, int depth, std::uint64_t& nodes) const {
+    const Entry& entry = table[key % entries];
+    std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+    if ((entry.check.load(std::memory_order_relaxed) ^ data) != key ||
+        static_cast<int>(data & 0xFF) != depth) {
+        return false;
+    }
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftTable::store(std::uint64_t key, int depth, std::uint64_t nodes) {
+    Entry& entry = table[key % entries];
+    std::uint64_t data = (nodes << 8) | static_cast<std::uint64_t>(depth);
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+std::uint64_t perft(Chess& position, int depth, PerftTable* table) {
+    if (depth == 0) {
+        return 1;
+    }
+
+    MoveList moves = position.generateMoves(position.getCurrentPlayer());
+    if (depth == 1) {
+        return moves.size();
+    }
+
+    std::uint64_t nodes = 0;
+    if (table && table->probe(position.getPositionKey(), depth, nodes)) {
+        return nodes;
+    }
+
+    for (Move move : moves) {
+        position.makeMove(move);
+        nodes += perft(position, depth - 1, table);
+        position.unmakeMove();
+    }
+
+    if (table) {
+        table->store(position.getPositionKey(), depth, nodes);
+    }
+    return nodes;
+}
+
+std::vector<PerftResult> perftDivide(const Chess& position, int depth, int threads,
+                                     PerftTable* table) {
+    MoveList moves = position.generateMoves(position.getCurrentPlayer());
+    std::vector<PerftResult> results(moves.size());
+    for (int i = 0; i < moves.size(); ++i) {
+        results[i] = {moves[i], 0};
+    }
+    if (depth < 1) {
+        return results;
+    }
+
+    // Workers pull root moves off a shared counter, each on its own copy
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        Chess local = position;
+        for (int i = next++; i < moves.size(); i = next++) {
+            local.makeMove(moves[i]);
+            results[i].nodes = perft(local, depth - 1, table);
+            local.unmakeMove();
+        }
+    };
+
+    threads = std::max(1, std::min(threads, moves.size()));
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    return results;
+}
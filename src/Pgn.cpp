@@ -0,0 +1,204 @@
+#include "Pgn.h"
+
+namespace {
+
+const PieceType PROMOTIONS[4] = {
+    PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN
+};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Characters that end a movetext token
+bool isDelimiter(char c) {
+    return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';';
+}
+
+bool previousLineIsTag(std::string_view text, std::size_t lineStart) {
+    if (lineStart < 2) {
+        return false;
+    }
+    std::size_t newline = text.rfind('\n', lineStart - 2);
+    std::size_t previous = newline == std::string_view::npos ? 0 : newline + 1;
+    return text[previous] == '[';
+}
+
+std::size_t skipToLineEnd(std::string_view text, std::size_t i) {
+    std::size_t end = text.find('\n', i);
+    return end == std::string_view::npos ? text.size() : end + 1;
+}
+
+std::size_t skipComment(std::string_view text, std::size_t i) {
+    std::size_t end = text.find('}', i);
+    return end == std::string_view::npos ? text.size() : end + 1;
+}
+
+// i is on the opening '('; variations nest and may hold comments
+std::size_t skipVariation(std::string_view text, std::size_t i) {
+    int depth = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '{') {
+            i = skipComment(text, i);
+            continue;
+        }
+        if (c == ';') {
+            i = skipToLineEnd(text, i);
+            continue;
+        }
+        ++i;
+        if (c == '(') {
+            ++depth;
+        } else if (c == ')' && --depth == 0) {
+            break;
+        }
+    }
+    return i;
+}
+
+bool isResult(std::string_view token) {
+    return token == "*" || token == "1-0" || token == "0-1" || token == "1/2-1/2";
+}
+
+}
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    std::string_view rest = tags;
+    while (!rest.empty()) {
+        std::size_t end = rest.find('\n');
+        std::string_view line = rest.substr(0, end);
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+
+        // [Name "value"]
+        if (line.size() > name.size() + 2 && line[0] == '[' &&
+            line.substr(1, name.size()) == name && line[name.size() + 1] == ' ') {
+            std::size_t open = line.find('"');
+            std::size_t close = line.rfind('"');
+            if (open != std::string_view::npos && close > open) {
+                return line.substr(open + 1, close - open - 1);
+            }
+        }
+    }
+    return std::string_view();
+}
+
+std::size_t findGameStart(std::string_view text, std::size_t offset) {
+    // Begin at the start of a line
+    std::size_t pos = offset;
+    if (pos > 0 && pos < text.size() && text[pos - 1] != '\n') {
+        pos = skipToLineEnd(text, pos);
+    }
+    while (pos < text.size()) {
+        if (text[pos] == '[' && !previousLineIsTag(text, pos)) {
+            return pos;
+        }
+        std::size_t next = text.find("\n[", pos);
+        if (next == std::string_view::npos) {
+            break;
+        }
+        pos = next + 1;
+    }
+    return text.size();
+}
+
+bool PgnReader::next(PgnGame& game) {
+    while (position < text.size() && isSpace(text[position])) {
+        ++position;
+    }
+    if (position >= text.size()) {
+        return false;
+    }
+
+    std::size_t tagsEnd = position;
+    while (tagsEnd < text.size() && text[tagsEnd] == '[') {
+        tagsEnd = skipToLineEnd(text, tagsEnd);
+    }
+    std::size_t end = findGameStart(text, tagsEnd);
+
+    game.offset = position;
+    game.tags = text.substr(position, tagsEnd - position);
+    game.movetext = text.substr(tagsEnd, end - tagsEnd);
+    position = end;
+    return true;
+}
+
+ReplayResult replayGame(const PgnGame& game, Chess& position) {
+    ReplayResult result;
+    std::string_view fen = game.tag("FEN");
+    if (fen.empty()) {
+        position.resetBoard();
+    } else if (!position.loadFen(fen)) {
+        result.error = fen;
+        return result;
+    }
+
+    std::string_view text = game.movetext;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (isSpace(c)) {
+            ++i;
+            continue;
+        }
+        if (c == '{') {
+            i = skipComment(text, i);
+            continue;
+        }
+        if (c == ';' || (c == '%' && (i == 0 || text[i - 1] == '\n'))) {
+            i = skipToLineEnd(text, i);
+            continue;
+        }
+        if (c == '(') {
+            i = skipVariation(text, i);
+            continue;
+        }
+
+        std::size_t start = i;
+        while (i < text.size() && !isDelimiter(text[i])) {
+            ++i;
+        }
+        std::string_view token = text.substr(start, i - start);
+        if (token.empty()) {
+            // A stray ')' or '}'
+            ++i;
+            continue;
+        }
+        if (isResult(token)) {
+            break;
+        }
+        if (token[0] == '$' || token == "e.p.") {
+            continue;
+        }
+
+        // Move numbers, possibly run together with the move ("12.e4", "12...Nf6")
+        std::size_t digits = 0;
+        while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9') {
+            ++digits;
+        }
+        if (digits == token.size()) {
+            continue;
+        }
+        if (digits > 0 && token[digits] == '.') {
+            while (digits < token.size() && token[digits] == '.') {
+                ++digits;
+            }
+            token.remove_prefix(digits);
+            if (token.empty()) {
+                continue;
+            }
+        }
+
+        Move move = position.parseSanMove(token);
+        if (move.isNone() ||
+            !position.movePiece(move.fromRow(), move.fromCol(), move.toRow(), move.toCol())) {
+            result.error = token;
+            return result;
+        }
+        if (move.isPromotion()) {
+            position.promotePawn(move.toRow(), move.toCol(), PROMOTIONS[move.promotionIndex()]);
+        }
+        ++result.plies;
+    }
+    return result;
+}
@@ -0,0 +1,204 @@
+#include "Polyglot.h"
+#include <algorithm>
+
+namespace {
+
+constexpr int ENTRY_SIZE = 16;
+
+// Offsets into the Random64 table
+constexpr int CASTLE_OFFSET = 768;
+constexpr int EN_PASSANT_OFFSET = 772;
+constexpr int TURN_OFFSET = 780;
+
+// Key of the starting position given in the format specification
+constexpr std::uint64_t START_POSITION_KEY = 0x463B96181691FC9CULL;
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = static_cast<char>(c | 0x20);
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+std::uint64_t readBigEndian(const char* data, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return value;
+}
+
+// Book moves store squares with rank 1 as row 0, and castling as the king
+// taking its own rook
+Move decodeMove(const Chess& position, std::uint16_t raw) {
+    int toCol = raw & 7;
+    int toRow = 7 - ((raw >> 3) & 7);
+    int fromCol = (raw >> 6) & 7;
+    int fromRow = 7 - ((raw >> 9) & 7);
+    int promotion = (raw >> 12) & 7;  // 1-4 for knight to queen
+
+    const Piece& piece = position.getPiece(fromRow, fromCol);
+    if (piece.type == PieceType::KING && fromCol == 4 && toRow == fromRow && (toCol == 0 || toCol == 7)) {
+        toCol = toCol == 7 ? 6 : 2;
+    }
+
+    for (Move move : position.getValidMoves(fromRow, fromCol)) {
+        if (move.toRow() == toRow && move.toCol() == toCol &&
+            (move.isPromotion() ? move.promotionIndex() == promotion - 1 : promotion == 0)) {
+            return move;
+        }
+    }
+    return Move::none();
+}
+
+}
+
+bool PolyglotKeys::load(const std::string& path) {
+    loaded = false;
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    // Take every run of exactly 16 hex digits, so a plain list works as
+    // well as a C array ("0x9D39247E33776D41ULL,") with comments around it
+    std::string_view text = file.view();
+    int count = 0;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (hexValue(text[i]) < 0) {
+            ++i;
+            continue;
+        }
+        std::size_t start = i;
+        std::uint64_t value = 0;
+        while (i < text.size() && hexValue(text[i]) >= 0) {
+            value = (value << 4) | static_cast<std::uint64_t>(hexValue(text[i]));
+            ++i;
+        }
+        if (i - start == 16) {
+            if (count == COUNT) {
+                return false;
+            }
+            randoms[count++] = value;
+        }
+    }
+    if (count != COUNT) {
+        return false;
+    }
+
+    loaded = key(Chess()) == START_POSITION_KEY;
+    return loaded;
+}
+
+std::uint64_t PolyglotKeys::key(const Chess& position) const {
+    std::uint64_t result = 0;
+
+    // Pieces are numbered black pawn, white pawn, black knight, ... white king
+    for (PieceColor color : {PieceColor::WHITE, PieceColor::BLACK}) {
+        for (int type = static_cast<int>(PieceType::PAWN); type <= static_cast<int>(PieceType::KING); ++type) {
+            int kind = 2 * (type - 1) + (color == PieceColor::WHITE ? 1 : 0);
+            Bitboard pieces = position.getPieces(color, static_cast<PieceType>(type));
+            while (pieces) {
+                int square = popLsb(pieces);
+                result ^= randoms[64 * kind + 8 * (7 - rowOf(square)) + colOf(square)];
+            }
+        }
+    }
+
+    // White kingside, white queenside, black kingside, black queenside: the
+    // same order as the CastlingRight bits
+    int rights = position.getCastlingRights();
+    for (int i = 0; i < 4; ++i) {
+        if (rights & (1 << i)) {
+            result ^= randoms[CASTLE_OFFSET + i];
+        }
+    }
+
+    // Chess keeps the en passant square only when a pawn can take there,
+    // which is also when Polyglot counts it
+    int enPassant = position.getEnPassantSquare();
+    if (enPassant >= 0) {
+        result ^= randoms[EN_PASSANT_OFFSET + colOf(enPassant)];
+    }
+
+    if (position.getCurrentPlayer() == PieceColor::WHITE) {
+        result ^= randoms[TURN_OFFSET];
+    }
+    return result;
+}
+
+bool PolyglotBook::open(const std::string& bookPath, const std::string& keysPath) {
+    close();
+    if (!file.open(bookPath, MappedFile::Access::Random) || file.size() % ENTRY_SIZE != 0 || !keys.load(keysPath)) {
+        close();
+        return false;
+    }
+    entryCount = file.size() / ENTRY_SIZE;
+    return entryCount > 0;
+}
+
+void PolyglotBook::close() {
+    file.close();
+    entryCount = 0;
+}
+
+std::vector<BookMove> PolyglotBook::lookup(const Chess& position) const {
+    std::vector<BookMove> moves;
+    if (!isOpen()) {
+        return moves;
+    }
+
+    // First entry with this key
+    std::uint64_t key = keys.key(position);
+    const char* data = file.data();
+    std::size_t low = 0;
+    std::size_t high = entryCount;
+    while (low < high) {
+        std::size_t middle = low + (high - low) / 2;
+        if (readBigEndian(data + middle * ENTRY_SIZE, 8) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (std::size_t i = low; i < entryCount; ++i) {
+        const char* entry = data + i * ENTRY_SIZE;
+        if (readBigEndian(entry, 8) != key) {
+            break;
+        }
+        Move move = decodeMove(position, static_cast<std::uint16_t>(readBigEndian(entry + 8, 2)));
+        int weight = static_cast<int>(readBigEndian(entry + 10, 2));
+        // Moves that are not legal here belong to a colliding key
+        if (!move.isNone()) {
+            moves.push_back({move, weight});
+        }
+    }
+
+    std::stable_sort(moves.begin(), moves.end(), [](const BookMove& a, const BookMove& b) {
+        return a.weight > b.weight;
+    });
+    return moves;
+}
+
+Move PolyglotBook::pick(const Chess& position, std::uint64_t random) const {
+    std::vector<BookMove> moves = lookup(position);
+    std::uint64_t total = 0;
+    for (const BookMove& entry : moves) {
+        total += static_cast<std::uint64_t>(entry.weight);
+    }
+    if (total == 0) {
+        return Move::none();
+    }
+
+    std::uint64_t target = random % total;
+    for (const BookMove& entry : moves) {
+        if (target < static_cast<std::uint64_t>(entry.weight)) {
+            return entry.move;
+        }
+        target -= static_cast<std::uint64_t>(entry.weight);
+    }
+    return Move::none();
+}
@@ -0,0 +1,106 @@
+#include "PositionCache.h"
+#include <cstring>
+#include <new>
+
+namespace {
+
+constexpr std::uint64_t HEADER_USED = 1ULL << 9;
+constexpr std::uint64_t HEADER_IN_CHECK = 1ULL << 8;
+
+int wordsFor(int moveCount) {
+    return (moveCount + 3) / 4;
+}
+
+}
+
+PositionCache::PositionCache(std::size_t megabytes, bool hugePages) {
+    resize(megabytes, hugePages);
+}
+
+void PositionCache::resize(std::size_t megabytes, bool hugePages) {
+    buckets = megabytes * 1024 * 1024 / sizeof(Bucket);
+    if (buckets == 0) {
+        buckets = 1;
+    }
+    memory.allocate(buckets * sizeof(Bucket), hugePages);
+    table = new (memory.data()) Bucket[buckets];
+    clear();
+}
+
+void PositionCache::clear() {
+    std::memset(static_cast<void*>(table), 0, buckets * sizeof(Bucket));
+}
+
+PositionCache::Bucket& PositionCache::bucketFor(std::uint64_t key) const {
+    // Map the key onto [0, buckets) without needing a power-of-two size
+    std::size_t index = static_cast<std::size_t>((static_cast<unsigned __int128>(key) * buckets) >> 64);
+    return table[index];
+}
+
+bool PositionCache::probe(std::uint64_t key, Result& result) const {
+    const Bucket& bucket = bucketFor(key);
+
+    for (const Entry& entry : bucket.entries) {
+        std::uint64_t header = entry.header.load(std::memory_order_relaxed);
+        if (!(header & HEADER_USED)) {
+            continue;
+        }
+
+        int count = static_cast<int>(header & 0xFF);
+        if (count > MAX_CACHED_MOVES) {
+            continue;
+        }
+        std::uint64_t words[MAX_CACHED_MOVES / 4];
+        std::uint64_t check = key ^ header;
+        for (int i = 0; i < wordsFor(count); ++i) {
+            words[i] = entry.moves[i].load(std::memory_order_relaxed);
+            check ^= words[i];
+        }
+        if (entry.check.load(std::memory_order_relaxed) != check) {
+            continue;
+        }
+
+        result.moves.clear();
+        for (int i = 0; i < count; ++i) {
+            result.moves.add(Move::fromRaw(static_cast<std::uint16_t>(words[i / 4] >> (16 * (i % 4)))));
+        }
+        result.inCheck = (header & HEADER_IN_CHECK) != 0;
+        return true;
+    }
+    return false;
+}
+
+void PositionCache::store(std::uint64_t key, const Result& result) {
+    int count = result.moves.size();
+    if (count > MAX_CACHED_MOVES) {
+        return;
+    }
+
+    Bucket& bucket = bucketFor(key);
+
+    // Take an empty slot if there is one, otherwise let the key pick a victim
+    Entry* target = &bucket.entries[key % BUCKET_SIZE];
+    for (Entry& entry : bucket.entries) {
+        if (!(entry.header.load(std::memory_order_relaxed) & HEADER_USED)) {
+            target = &entry;
+            break;
+        }
+    }
+
+    std::uint64_t header = HEADER_USED | static_cast<std::uint64_t>(count);
+    if (result.inCheck) {
+        header |= HEADER_IN_CHECK;
+    }
+
+    std::uint64_t check = key ^ header;
+    for (int i = 0; i < wordsFor(count); ++i) {
+        std::uint64_t word = 0;
+        for (int j = 0; j < 4 && i * 4 + j < count; ++j) {
+            word |= static_cast<std::uint64_t>(result.moves[i * 4 + j].raw()) << (16 * j);
+        }
+        target->moves[i].store(word, std::memory_order_relaxed);
+        check ^= word;
+    }
+    target->header.store(header, std::memory_order_relaxed);
+    target->check.store(check, std::memory_order_relaxed);
+}
@@ -0,0 +1,394 @@
+#include "Search.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+constexpr int INFINITE_SCORE = Search::MATE_SCORE + 1;
+
+// Rough piece values for capture ordering, indexed by PieceType
+constexpr int PIECE_VALUES[7] = {0, 100, 320, 330, 500, 900, 0};
+
+// Move ordering bands, highest first
+constexpr int ORDER_FIRST = 3000000;
+constexpr int ORDER_CAPTURE = 2000000;
+constexpr int ORDER_KILLER = 1000000;
+constexpr int HISTORY_LIMIT = 900000;
+
+int sideIndex(PieceColor color) {
+    return color == PieceColor::WHITE ? 0 : 1;
+}
+
+// Mate scores are stored relative to the node rather than the root, so a
+// mate found through a transposition keeps the right distance
+int scoreToTable(int score, int ply) {
+    if (score >= Search::MATE_SCORE - Search::MAX_PLY) {
+        return score + ply;
+    }
+    if (score <= -Search::MATE_SCORE + Search::MAX_PLY) {
+        return score - ply;
+    }
+    return score;
+}
+
+int scoreFromTable(int score, int ply) {
+    if (score >= Search::MATE_SCORE - Search::MAX_PLY) {
+        return score - ply;
+    }
+    if (score <= -Search::MATE_SCORE + Search::MAX_PLY) {
+        return score + ply;
+    }
+    return score;
+}
+
+// Swaps the best-scored remaining move into slot index
+void pickNext(MoveList& moves, int* scores, int index) {
+    int best = index;
+    for (int i = index + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+    std::swap(moves[index], moves[best]);
+    std::swap(scores[index], scores[best]);
+}
+
+}
+
+// One search thread: its own position copy, make/unmake stack and move
+// ordering tables. Workers only share the transposition table and the stop
+// flag of their Search.
+class Search::Worker {
+public:
+    Worker(Search& owner, int id) : nodes(0), owner(owner), id(id), stopped(false),
+                                    rootBest(Move::none()) {}
+
+    std::atomic<std::uint64_t> nodes;
+
+    void reset(const Chess& root);
+
+    // Iterative deepening up to maxDepth or until the search is stopped.
+    // Only the main worker (id 0) fills in owner.info and reports progress.
+    Move iterate(int maxDepth, const InfoCallback& onIteration);
+
+private:
+    Search& owner;
+    int id;
+    Chess position;
+    bool stopped;
+
+    Move rootBest;
+    Move killers[MAX_PLY][2];
+    int history[2][64][64];
+
+    int negamax(int depth, int ply, int alpha, int beta);
+    int quiescence(int ply, int alpha, int beta);
+    void scoreMoves(const MoveList& moves, int* scores, int ply, Move firstMove) const;
+    bool checkTime();
+    void countNode() { nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+};
+
+Search::Search(int threads, std::size_t hashMegabytes)
+    : table(hashMegabytes), stopRequested(false), timeLimited(false) {
+    setThreads(threads);
+}
+
+Search::~Search() = default;
+
+void Search::setThreads(int threads) {
+    threads = std::max(1, threads);
+    workers.clear();
+    for (int i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+    }
+}
+
+void Search::setHashSize(std::size_t megabytes, bool hugePages) {
+    table.resize(megabytes, hugePages);
+}
+
+void Search::clearHash() {
+    table.clear();
+}
+
+void Search::prepare() {
+    stopRequested = false;
+}
+
+void Search::stop() {
+    stopRequested = true;
+}
+
+std::uint64_t Search::totalNodes() const {
+    std::uint64_t total = 0;
+    for (const auto& worker : workers) {
+        total += worker->nodes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Move Search::bestMove(const Chess& root, int timeMs, int maxDepth, const InfoCallback& onIteration) {
+    info = SearchInfo();
+    startTime = std::chrono::steady_clock::now();
+    timeLimited = timeMs > 0;
+    deadline = startTime + std::chrono::milliseconds(std::max(1, timeMs));
+
+    if (root.generateMoves(root.getCurrentPlayer()).empty()) {
+        prepare();
+        return Move::none();
+    }
+
+    table.newSearch();
+    for (auto& worker : workers) {
+        worker->reset(root);
+    }
+    maxDepth = std::max(1, std::min(maxDepth, MAX_PLY - 1));
+
+    std::vector<std::thread> helpers;
+    for (std::size_t i = 1; i < workers.size(); ++i) {
+        helpers.emplace_back([this, i, maxDepth]() {
+            workers[i]->iterate(maxDepth, InfoCallback());
+        });
+    }
+
+    Move best = workers[0]->iterate(maxDepth, onIteration);
+
+    // Helpers may still be busy on deeper iterations
+    stopRequested = true;
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+    info.nodes = totalNodes();
+    prepare();
+    return best;
+}
+
+void Search::Worker::reset(const Chess& root) {
+    position = root;
+    nodes = 0;
+    stopped = false;
+    std::memset(killers, 0, sizeof(killers));
+    std::memset(history, 0, sizeof(history));
+    rootBest = position.generateMoves(position.getCurrentPlayer())[0];
+}
+
+Move Search::Worker::iterate(int maxDepth, const InfoCallback& onIteration) {
+    // Always have something to play, even if the first iteration is cut short
+    Move best = rootBest;
+
+    // Odd helpers start one ply deeper so the threads spread over depths
+    for (int depth = 1 + (id & 1); depth <= maxDepth; ++depth) {
+        int score = negamax(depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+        if (stopped) {
+            break;
+        }
+        best = rootBest;
+
+        if (id == 0) {
+            auto elapsed = std::chrono::steady_clock::now() - owner.startTime;
+            SearchInfo& info = owner.info;
+            info.depth = depth;
+            info.score = score;
+            info.nodes = owner.totalNodes();
+            info.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            info.elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+            info.bestMove = best;
+            if (onIteration) {
+                onIteration(info);
+            }
+        }
+
+        // A forced mate will not get any better with more depth
+        if (score >= MATE_SCORE - MAX_PLY || score <= -MATE_SCORE + MAX_PLY) {
+            break;
+        }
+    }
+    return best;
+}
+
+bool Search::Worker::checkTime() {
+    if (owner.stopRequested.load(std::memory_order_relaxed)) {
+        stopped = true;
+    } else if (owner.timeLimited && std::chrono::steady_clock::now() >= owner.deadline) {
+        owner.stopRequested = true;
+        stopped = true;
+    }
+    return stopped;
+}
+
+int Search::Worker::negamax(int depth, int ply, int alpha, int beta) {
+    bool inCheck = position.isCheck();
+    if (inCheck && ply < MAX_PLY / 2) {
+        ++depth;
+    }
+    if (depth <= 0) {
+        return quiescence(ply, alpha, beta);
+    }
+
+    countNode();
+    if (stopped || ((nodes.load(std::memory_order_relaxed) & 2047) == 0 && checkTime())) {
+        return 0;
+    }
+    // A repeated position is a draw if the players keep repeating it; the
+    // side that could do better has to show it by playing something else
+    if (ply > 0 && position.isRepetition()) {
+        return 0;
+    }
+
+    std::uint64_t key = position.getPositionKey();
+    Move hashMove = Move::none();
+    TranspositionTable::Hit hit;
+    if (owner.table.probe(key, hit)) {
+        hashMove = hit.move;
+        int score = scoreFromTable(hit.score, ply);
+        if (ply > 0 && hit.depth >= depth &&
+            (hit.bound == TranspositionTable::BOUND_EXACT ||
+             (hit.bound == TranspositionTable::BOUND_LOWER && score >= beta) ||
+             (hit.bound == TranspositionTable::BOUND_UPPER && score <= alpha))) {
+            return score;
+        }
+    }
+
+    MoveList moves = position.generateMoves(position.getCurrentPlayer());
+    if (moves.empty()) {
+        // Prefer the quickest mate and the slowest loss
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+    // Fifty moves without a capture or pawn move, unless that ended in mate
+    if (ply > 0 && position.getHalfmoveClock() >= 100) {
+        return 0;
+    }
+    if (ply >= MAX_PLY - 1) {
+        return position.evaluate();
+    }
+
+    int scores[MoveList::CAPACITY];
+    Move firstMove = (ply == 0 && hashMove.isNone()) ? rootBest : hashMove;
+    scoreMoves(moves, scores, ply, firstMove);
+
+    int side = sideIndex(position.getCurrentPlayer());
+    int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove = Move::none();
+    for (int i = 0; i < moves.size(); ++i) {
+        pickNext(moves, scores, i);
+        Move move = moves[i];
+
+        position.makeMove(move);
+        int score;
+        if (i == 0) {
+            score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            // Prove the move is no better with a null window, re-search if it is
+            score = -negamax(depth - 1, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta) {
+                score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        position.unmakeMove();
+
+        if (stopped) {
+            return 0;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (ply == 0) {
+                rootBest = move;
+            }
+        }
+        if (score > alpha) {
+            alpha = score;
+        }
+        if (alpha >= beta) {
+            if (!move.isCapture() && !move.isPromotion()) {
+                if (killers[ply][0] != move) {
+                    killers[ply][1] = killers[ply][0];
+                    killers[ply][0] = move;
+                }
+                int& entry = history[side][move.from()][move.to()];
+                entry = std::min(entry + depth * depth, HISTORY_LIMIT);
+            }
+            break;
+        }
+    }
+
+    TranspositionTable::Bound bound = bestScore >= beta ? TranspositionTable::BOUND_LOWER
+        : bestScore > originalAlpha ? TranspositionTable::BOUND_EXACT : TranspositionTable::BOUND_UPPER;
+    owner.table.store(key, bestMove, scoreToTable(bestScore, ply), depth, bound);
+    return bestScore;
+}
+
+int Search::Worker::quiescence(int ply, int alpha, int beta) {
+    countNode();
+    if (stopped || ((nodes.load(std::memory_order_relaxed) & 2047) == 0 && checkTime())) {
+        return 0;
+    }
+
+    int standPat = position.evaluate();
+    if (standPat >= beta || ply >= MAX_PLY - 1) {
+        return standPat;
+    }
+    if (standPat > alpha) {
+        alpha = standPat;
+    }
+
+    // Only captures and promotions are played out
+    MoveList all = position.generateMoves(position.getCurrentPlayer());
+    MoveList moves;
+    for (Move move : all) {
+        if (move.isCapture() || move.isPromotion()) {
+            moves.add(move);
+        }
+    }
+
+    int scores[MoveList::CAPACITY];
+    scoreMoves(moves, scores, ply, Move::none());
+
+    for (int i = 0; i < moves.size(); ++i) {
+        pickNext(moves, scores, i);
+        position.makeMove(moves[i]);
+        int score = -quiescence(ply + 1, -beta, -alpha);
+        position.unmakeMove();
+
+        if (stopped) {
+            return 0;
+        }
+        if (score >= beta) {
+            return score;
+        }
+        if (score > alpha) {
+            alpha = score;
+        }
+    }
+    return alpha;
+}
+
+void Search::Worker::scoreMoves(const MoveList& moves, int* scores, int ply, Move firstMove) const {
+    int side = sideIndex(position.getCurrentPlayer());
+
+    for (int i = 0; i < moves.size(); ++i) {
+        Move move = moves[i];
+        if (move == firstMove) {
+            scores[i] = ORDER_FIRST;
+        } else if (move.isCapture() || move.isPromotion()) {
+            // Most valuable victim, least valuable attacker
+            const Piece& attacker = position.getPiece(move.fromRow(), move.fromCol());
+            const Piece& victim = position.getPiece(move.toRow(), move.toCol());
+            int victimValue = (move.flag() == Move::EN_PASSANT) ? PIECE_VALUES[1]
+                : PIECE_VALUES[static_cast<int>(victim.type)];
+            if (move.isPromotion()) {
+                victimValue += PIECE_VALUES[static_cast<int>(PieceType::KNIGHT) + move.promotionIndex()];
+            }
+            scores[i] = ORDER_CAPTURE + victimValue * 16 - PIECE_VALUES[static_cast<int>(attacker.type)] / 16;
+        } else if (move == killers[ply][0]) {
+            scores[i] = ORDER_KILLER + 1;
+        } else if (move == killers[ply][1]) {
+            scores[i] = ORDER_KILLER;
+        } else {
+            scores[i] = history[side][move.from()][move.to()];
+        }
+    }
+}
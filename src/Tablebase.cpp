@@ -0,0 +1,399 @@
+#include "Tablebase.h"
+#include <algorithm>
+
+namespace {
+
+// Kings first, then the order pieces are named in
+constexpr PieceType NAME_ORDER[] = {
+    PieceType::KING, PieceType::QUEEN, PieceType::ROOK,
+    PieceType::BISHOP, PieceType::KNIGHT, PieceType::PAWN
+};
+constexpr char NAME_LETTERS[] = "KQRBNP";
+
+int nameRank(PieceType type) {
+    for (int i = 0; i < 6; ++i) {
+        if (NAME_ORDER[i] == type) {
+            return i;
+        }
+    }
+    return 6;
+}
+
+PieceColor opposite(PieceColor color) {
+    return color == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE;
+}
+
+// Squares of the a1-d1-d4 triangle, numbered in square order
+struct KingSlots {
+    int slotOf[64];
+    int squareOf[10];
+};
+
+constexpr KingSlots makeKingSlots() {
+    KingSlots slots{};
+    int next = 0;
+    for (int square = 0; square < 64; ++square) {
+        int file = colOf(square);
+        int rank = 7 - rowOf(square);
+        if (file <= 3 && rank <= file) {
+            slots.slotOf[square] = next;
+            slots.squareOf[next++] = square;
+        } else {
+            slots.slotOf[square] = -1;
+        }
+    }
+    return slots;
+}
+
+constexpr KingSlots TRIANGLE = makeKingSlots();
+
+// Reflection in the a1-h8 diagonal
+constexpr int flipDiagonal(int square) {
+    return (7 - colOf(square)) * 8 + (7 - rowOf(square));
+}
+
+std::uint64_t readLittleEndian(const unsigned char* data, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+int readEntry(const unsigned char* entries, int bits, std::uint64_t index) {
+    std::uint64_t bit = index * static_cast<std::uint64_t>(bits);
+    std::uint64_t word = readLittleEndian(entries + bit / 8, 8);
+    return static_cast<int>((word >> (bit % 8)) & ((std::uint64_t(1) << bits) - 1));
+}
+
+}
+
+bool TablebaseLayout::assign(std::array<Piece, MAX_PIECES> list, int size) {
+    // White first, then in name order; a handful of pieces, so by insertion
+    auto before = [](const Piece& a, const Piece& b) {
+        if (a.color != b.color) {
+            return a.color == PieceColor::WHITE;
+        }
+        return nameRank(a.type) < nameRank(b.type);
+    };
+    for (int i = 1; i < size; ++i) {
+        for (int j = i; j > 0 && before(list[j], list[j - 1]); --j) {
+            std::swap(list[j], list[j - 1]);
+        }
+    }
+
+    int kings = 0;
+    bool pawns = false;
+    for (int i = 0; i < size; ++i) {
+        if (list[i].type == PieceType::KING) {
+            ++kings;
+        }
+        pawns = pawns || list[i].type == PieceType::PAWN;
+    }
+    // Sorted, so a valid list starts with the white king
+    if (kings != 2 || list[0].type != PieceType::KING || list[0].color != PieceColor::WHITE) {
+        return false;
+    }
+
+    pieces = list;
+    count = size;
+    kingSlots = pawns ? 32 : 10;
+    return true;
+}
+
+bool TablebaseLayout::parse(std::string_view name, TablebaseLayout& layout) {
+    std::array<Piece, MAX_PIECES> list;
+    int size = 0;
+    PieceColor color = PieceColor::WHITE;
+    for (char c : name) {
+        if (c == 'v' && color == PieceColor::WHITE) {
+            color = PieceColor::BLACK;
+            continue;
+        }
+        const char* letter = std::find(NAME_LETTERS, NAME_LETTERS + 6, c);
+        if (letter == NAME_LETTERS + 6 || size == MAX_PIECES) {
+            return false;
+        }
+        list[size++] = Piece(NAME_ORDER[letter - NAME_LETTERS], color);
+    }
+    if (color != PieceColor::BLACK) {
+        return false;
+    }
+
+    // One king a side, not two on one side
+    int whiteKings = 0;
+    for (int i = 0; i < size; ++i) {
+        if (list[i].type == PieceType::KING && list[i].color == PieceColor::WHITE) {
+            ++whiteKings;
+        }
+    }
+    return whiteKings == 1 && layout.assign(list, size);
+}
+
+bool TablebaseLayout::ofPosition(const Chess& position, TablebaseLayout& layout) {
+    std::array<Piece, MAX_PIECES> list;
+    int size = 0;
+    for (PieceColor color : {PieceColor::WHITE, PieceColor::BLACK}) {
+        if (popCount(position.getPieces(color, PieceType::KING)) != 1) {
+            return false;
+        }
+        for (PieceType type : NAME_ORDER) {
+            int pieceCount = popCount(position.getPieces(color, type));
+            if (size + pieceCount > MAX_PIECES) {
+                return false;
+            }
+            for (int i = 0; i < pieceCount; ++i) {
+                list[size++] = Piece(type, color);
+            }
+        }
+    }
+    return layout.assign(list, size);
+}
+
+std::string TablebaseLayout::name() const {
+    std::string text;
+    for (int i = 0; i < count; ++i) {
+        if (i > 0 && pieces[i].color != pieces[i - 1].color) {
+            text += 'v';
+        }
+        text += NAME_LETTERS[nameRank(pieces[i].type)];
+    }
+    return text;
+}
+
+TablebaseLayout TablebaseLayout::swapped() const {
+    std::array<Piece, MAX_PIECES> list = pieces;
+    for (int i = 0; i < count; ++i) {
+        list[i].color = opposite(list[i].color);
+    }
+    TablebaseLayout layout;
+    layout.assign(list, count);
+    return layout;
+}
+
+bool TablebaseLayout::hasPawns() const {
+    return kingSlots == 32;
+}
+
+std::uint64_t TablebaseLayout::size() const {
+    std::uint64_t entries = 2 * static_cast<std::uint64_t>(kingSlots);
+    for (int i = 1; i < count; ++i) {
+        entries *= 64;
+    }
+    return entries;
+}
+
+std::uint64_t TablebaseLayout::index(const Chess& position, bool swapColors) const {
+    Squares squares{};
+    Bitboard remaining = 0;
+    for (int i = 0; i < count; ++i) {
+        // Identical pieces take the squares of one set in turn
+        if (i == 0 || pieces[i].type != pieces[i - 1].type || pieces[i].color != pieces[i - 1].color) {
+            PieceColor color = swapColors ? opposite(pieces[i].color) : pieces[i].color;
+            remaining = position.getPieces(color, pieces[i].type);
+        }
+        int square = popLsb(remaining);
+        squares[i] = swapColors ? square ^ 56 : square;
+    }
+    bool whiteToMove = (position.getCurrentPlayer() == PieceColor::WHITE) != swapColors;
+    return index(squares, whiteToMove);
+}
+
+std::uint64_t TablebaseLayout::index(Squares squares, bool whiteToMove) const {
+    // Move the white king into its part of the board, taking the other
+    // pieces along
+    if (colOf(squares[0]) > 3) {
+        for (int i = 0; i < count; ++i) {
+            squares[i] ^= 7;
+        }
+    }
+
+    if (hasPawns()) {
+        return encode(squares, rowOf(squares[0]) * 4 + colOf(squares[0]), whiteToMove);
+    }
+
+    if (rowOf(squares[0]) < 4) {
+        for (int i = 0; i < count; ++i) {
+            squares[i] ^= 56;
+        }
+    }
+    if (7 - rowOf(squares[0]) > colOf(squares[0])) {
+        for (int i = 0; i < count; ++i) {
+            squares[i] = flipDiagonal(squares[i]);
+        }
+    }
+
+    int slot = TRIANGLE.slotOf[squares[0]];
+    std::uint64_t result = encode(squares, slot, whiteToMove);
+    // A king on the diagonal stays in the triangle when the board is
+    // reflected in it; the smaller index of the two placements wins
+    if (7 - rowOf(squares[0]) == colOf(squares[0])) {
+        for (int i = 1; i < count; ++i) {
+            squares[i] = flipDiagonal(squares[i]);
+        }
+        result = std::min(result, encode(squares, slot, whiteToMove));
+    }
+    return result;
+}
+
+std::uint64_t TablebaseLayout::encode(Squares squares, int slot, bool whiteToMove) const {
+    // Identical pieces are numbered in square order
+    for (int i = 2; i < count; ++i) {
+        for (int j = i; j > 1 && pieces[j].type == pieces[j - 1].type &&
+                        pieces[j].color == pieces[j - 1].color && squares[j] < squares[j - 1]; --j) {
+            std::swap(squares[j], squares[j - 1]);
+        }
+    }
+
+    std::uint64_t result = (whiteToMove ? 0 : 1) * static_cast<std::uint64_t>(kingSlots) + static_cast<std::uint64_t>(slot);
+    for (int i = 1; i < count; ++i) {
+        result = result * 64 + static_cast<std::uint64_t>(squares[i]);
+    }
+    return result;
+}
+
+bool TablebaseLayout::decode(std::uint64_t index, Squares& squares, bool& whiteToMove) const {
+    for (int i = count - 1; i > 0; --i) {
+        squares[i] = static_cast<int>(index % 64);
+        index /= 64;
+    }
+    int slot = static_cast<int>(index % static_cast<std::uint64_t>(kingSlots));
+    whiteToMove = index / static_cast<std::uint64_t>(kingSlots) == 0;
+    squares[0] = hasPawns() ? squareOf(slot / 4, slot % 4) : TRIANGLE.squareOf[slot];
+
+    Bitboard occupied = 0;
+    for (int i = 0; i < count; ++i) {
+        Bitboard bit = squareBB(squares[i]);
+        if (occupied & bit) {
+            return false;
+        }
+        if (pieces[i].type == PieceType::PAWN && (bit & (ROW_0 | ROW_7))) {
+            return false;
+        }
+        occupied |= bit;
+    }
+    return true;
+}
+
+int TablebaseLayout::writeFen(const Squares& squares, bool whiteToMove, char* out) const {
+    char board[64];
+    std::fill(board, board + 64, '\0');
+    for (int i = 0; i < count; ++i) {
+        char letter = NAME_LETTERS[nameRank(pieces[i].type)];
+        board[squares[i]] = pieces[i].color == PieceColor::WHITE ? letter : static_cast<char>(letter | 0x20);
+    }
+
+    int length = 0;
+    for (int row = 0; row < 8; ++row) {
+        int empty = 0;
+        for (int col = 0; col < 8; ++col) {
+            char c = board[squareOf(row, col)];
+            if (c == '\0') {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                out[length++] = static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            out[length++] = c;
+        }
+        if (empty > 0) {
+            out[length++] = static_cast<char>('0' + empty);
+        }
+        if (row < 7) {
+            out[length++] = '/';
+        }
+    }
+
+    const char* rest = whiteToMove ? " w - - 0 1" : " b - - 0 1";
+    for (const char* c = rest; *c; ++c) {
+        out[length++] = *c;
+    }
+    return length;
+}
+
+void TablebaseHeader::write(char* out) const {
+    std::fill(out, out + SIZE, '\0');
+    std::copy(MAGIC, MAGIC + 4, out);
+    out[4] = static_cast<char>(bitsPerEntry);
+    std::copy(name.begin(), name.begin() + std::min<std::size_t>(name.size(), NAME_SIZE - 1), out + 8);
+    for (int i = 0; i < 8; ++i) {
+        out[24 + i] = static_cast<char>((entries >> (8 * i)) & 0xFF);
+    }
+}
+
+bool TablebaseHeader::read(const char* data, std::size_t size) {
+    if (size < static_cast<std::size_t>(SIZE) || !std::equal(MAGIC, MAGIC + 4, data)) {
+        return false;
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    bitsPerEntry = bytes[4];
+    const char* nameStart = data + 8;
+    name.assign(nameStart, std::find(nameStart, nameStart + NAME_SIZE, '\0'));
+    entries = readLittleEndian(bytes + 24, 8);
+    return bitsPerEntry >= 1 && bitsPerEntry <= 16;
+}
+
+bool Tablebase::addTable(const std::string& path) {
+    Table table;
+    TablebaseHeader header;
+    // Probes read single entries scattered over the file
+    if (!table.file.open(path, MappedFile::Access::Random) ||
+        !header.read(table.file.data(), table.file.size()) ||
+        !TablebaseLayout::parse(header.name, table.layout) ||
+        table.layout.name() != header.name || header.entries != table.layout.size()) {
+        return false;
+    }
+    // Entries plus the zero padding
+    std::uint64_t bytes = (header.entries * static_cast<std::uint64_t>(header.bitsPerEntry) + 7) / 8 + 8;
+    if (table.file.size() - TablebaseHeader::SIZE < bytes) {
+        return false;
+    }
+
+    table.bitsPerEntry = header.bitsPerEntry;
+    table.entries = reinterpret_cast<const unsigned char*>(table.file.data() + TablebaseHeader::SIZE);
+    if (byName.count(header.name) == 0) {
+        byName[header.name] = tables.size();
+        tables.push_back(std::move(table));
+    }
+    return true;
+}
+
+void Tablebase::close() {
+    tables.clear();
+    byName.clear();
+}
+
+bool Tablebase::covers(const TablebaseLayout& layout) const {
+    return byName.count(layout.name()) > 0 || byName.count(layout.swapped().name()) > 0;
+}
+
+bool Tablebase::probe(const Chess& position, TablebaseResult& result) const {
+    TablebaseLayout layout;
+    if (tables.empty() || position.getCastlingRights() != 0 || position.getEnPassantSquare() >= 0 ||
+        !TablebaseLayout::ofPosition(position, layout)) {
+        return false;
+    }
+
+    bool swapColors = false;
+    auto found = byName.find(layout.name());
+    if (found == byName.end()) {
+        swapColors = true;
+        found = byName.find(layout.swapped().name());
+        if (found == byName.end()) {
+            return false;
+        }
+    }
+
+    const Table& table = tables[found->second];
+    int entry = readEntry(table.entries, table.bitsPerEntry, table.layout.index(position, swapColors));
+    if (entry == 0) {
+        result.outcome = TablebaseResult::DRAW;
+        result.pliesToMate = 0;
+    } else {
+        result.pliesToMate = entry - 1;
+        result.outcome = result.pliesToMate % 2 == 1 ? TablebaseResult::WIN : TablebaseResult::LOSS;
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+#include "TranspositionTable.h"
+#include <cstring>
+#include <new>
+
+namespace {
+
+std::uint64_t pack(Move move, int score, int depth, TranspositionTable::Bound bound, std::uint8_t age) {
+    return static_cast<std::uint64_t>(move.raw()) |
+           static_cast<std::uint64_t>(static_cast<std::uint16_t>(score)) << 16 |
+           static_cast<std::uint64_t>(depth & 0xFF) << 32 |
+           static_cast<std::uint64_t>(bound) << 40 |
+           static_cast<std::uint64_t>(age) << 48;
+}
+
+int depthOf(std::uint64_t data) {
+    return static_cast<int>((data >> 32) & 0xFF);
+}
+
+std::uint8_t ageOf(std::uint64_t data) {
+    return static_cast<std::uint8_t>(data >> 48);
+}
+
+}
+
+TranspositionTable::TranspositionTable(std::size_t megabytes, bool hugePages) {
+    resize(megabytes, hugePages);
+}
+
+void TranspositionTable::resize(std::size_t megabytes, bool hugePages) {
+    buckets = megabytes * 1024 * 1024 / sizeof(Bucket);
+    if (buckets == 0) {
+        buckets = 1;
+    }
+    memory.allocate(buckets * sizeof(Bucket), hugePages);
+    table = new (memory.data()) Bucket[buckets];
+    clear();
+}
+
+void TranspositionTable::clear() {
+    std::memset(static_cast<void*>(table), 0, buckets * sizeof(Bucket));
+    age = 0;
+}
+
+void TranspositionTable::newSearch() {
+    ++age;
+}
+
+TranspositionTable::Bucket& TranspositionTable::bucketFor(std::uint64_t key) const {
+    std::size_t index = static_cast<std::size_t>((static_cast<unsigned __int128>(key) * buckets) >> 64);
+    return table[index];
+}
+
+bool TranspositionTable::probe(std::uint64_t key, Hit& hit) const {
+    const Bucket& bucket = bucketFor(key);
+
+    for (const Entry& entry : bucket.entries) {
+        std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ data) != key) {
+            continue;
+        }
+        Bound bound = static_cast<Bound>((data >> 40) & 3);
+        if (bound == BOUND_NONE) {
+            continue;
+        }
+        hit.move = Move::fromRaw(static_cast<std::uint16_t>(data));
+        hit.score = static_cast<std::int16_t>(data >> 16);
+        hit.depth = depthOf(data);
+        hit.bound = bound;
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t key, Move move, int score, int depth, Bound bound) {
+    Bucket& bucket = bucketFor(key);
+
+    // Overwrite this position's own entry, otherwise the shallowest or
+    // oldest one in the bucket
+    Entry* replace = &bucket.entries[0];
+    int worst = 1 << 30;
+    for (Entry& entry : bucket.entries) {
+        std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ data) == key) {
+            if (move.isNone()) {
+                move = Move::fromRaw(static_cast<std::uint16_t>(data));
+            }
+            replace = &entry;
+            break;
+        }
+        int staleness = static_cast<std::uint8_t>(age - ageOf(data));
+        int value = depthOf(data) - 8 * staleness;
+        if (value < worst) {
+            worst = value;
+            replace = &entry;
+        }
+    }
+
+    std::uint64_t data = pack(move, score, depth < 0 ? 0 : depth, bound, age);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+}
@@ -0,0 +1,143 @@
+#include "chesscore.h"
+#include "Chess.h"
+#include <cstring>
+#include <new>
+
+struct chess_position {
+    Chess game;
+};
+
+namespace {
+
+char pieceLetter(const Piece& piece) {
+    static const char letters[] = ".pnbrqk";
+    char letter = letters[static_cast<int>(piece.type)];
+    if (piece.color == PieceColor::WHITE) {
+        letter = static_cast<char>(letter - 'a' + 'A');
+    }
+    return letter;
+}
+
+}
+
+chess_position *chess_position_create(void) {
+    return new (std::nothrow) chess_position();
+}
+
+chess_position *chess_position_from_fen(const char *fen) {
+    chess_position *position = chess_position_create();
+    if (position && (!fen || !position->game.loadFen(fen))) {
+        delete position;
+        return nullptr;
+    }
+    return position;
+}
+
+chess_position *chess_position_clone(const chess_position *position) {
+    if (!position) {
+        return nullptr;
+    }
+    return new (std::nothrow) chess_position(*position);
+}
+
+void chess_position_destroy(chess_position *position) {
+    delete position;
+}
+
+int chess_position_set_fen(chess_position *position, const char *fen) {
+    return position && fen && position->game.loadFen(fen) ? 1 : 0;
+}
+
+int chess_position_get_fen(const chess_position *position, char *out, int capacity) {
+    if (!position || !out) {
+        return 0;
+    }
+    char fen[Chess::MAX_FEN_LENGTH];
+    int length = position->game.writeFen(fen);
+    if (length >= capacity) {
+        return 0;
+    }
+    std::memcpy(out, fen, static_cast<std::size_t>(length));
+    out[length] = '\0';
+    return length;
+}
+
+int chess_legal_moves(const chess_position *position, uint16_t *moves, int capacity) {
+    if (!position) {
+        return 0;
+    }
+    MoveList legal = position->game.generateMoves(position->game.getCurrentPlayer());
+    for (int i = 0; i < legal.size() && i < capacity; ++i) {
+        moves[i] = legal[i].raw();
+    }
+    return legal.size();
+}
+
+int chess_apply_move(chess_position *position, uint16_t move) {
+    if (!position) {
+        return 0;
+    }
+    Move candidate = Move::fromRaw(move);
+    if (!position->game.generateMoves(position->game.getCurrentPlayer()).contains(candidate)) {
+        return 0;
+    }
+    position->game.makeMove(candidate);
+    return 1;
+}
+
+int chess_apply_uci(chess_position *position, const char *uci) {
+    if (!position || !uci) {
+        return 0;
+    }
+    Move move = position->game.parseUciMove(uci);
+    if (move.isNone()) {
+        return 0;
+    }
+    position->game.makeMove(move);
+    return 1;
+}
+
+int chess_undo_move(chess_position *position) {
+    if (!position || !position->game.canUnmakeMove()) {
+        return 0;
+    }
+    position->game.unmakeMove();
+    return 1;
+}
+
+void chess_move_to_uci(uint16_t move, char out[6]) {
+    std::string text = Move::fromRaw(move).toUci();
+    std::memcpy(out, text.c_str(), text.size() + 1);
+}
+
+chess_status chess_get_status(const chess_position *position) {
+    if (!position) {
+        return CHESS_STATUS_ONGOING;
+    }
+    const GameStatus& status = position->game.getStatus();
+    if (status.checkmate) {
+        return CHESS_STATUS_CHECKMATE;
+    }
+    if (status.stalemate) {
+        return CHESS_STATUS_STALEMATE;
+    }
+    if (status.drawReason != DrawReason::NONE) {
+        return CHESS_STATUS_DRAW;
+    }
+    return status.inCheck ? CHESS_STATUS_CHECK : CHESS_STATUS_ONGOING;
+}
+
+int chess_side_to_move(const chess_position *position) {
+    return position && position->game.getCurrentPlayer() == PieceColor::BLACK ? 1 : 0;
+}
+
+char chess_piece_at(const chess_position *position, int square) {
+    if (!position || square < 0 || square >= 64) {
+        return '.';
+    }
+    return pieceLetter(position->game.getPiece(rowOf(square), colOf(square)));
+}
+
+uint64_t chess_position_key(const chess_position *position) {
+    return position ? position->game.getPositionKey() : 0;
+}
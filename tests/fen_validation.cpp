@@ -0,0 +1,72 @@
+// Chess::loadFen must turn away positions that cannot come up in a game,
+// since FEN arrives from files, the C API and the protocol server.
+
+#include <cstdio>
+#include "Chess.h"
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+}
+
+int main() {
+    const char* accepted[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        // The richest known position, 218 legal moves
+        "R6R/3Q4/1Q4Q1/4Q3/2Q4Q/Q4Q2/pp1Q4/kBNN1KB1 w - - 0 1",
+    };
+    for (const char* fen : accepted) {
+        Chess position;
+        if (!position.loadFen(fen)) {
+            std::fprintf(stderr, "FAILED: rejected %s\n", fen);
+            ++failures;
+        }
+    }
+    Chess richest;
+    richest.loadFen(accepted[3]);
+    expect(richest.generateMoves(PieceColor::WHITE).size() == 218, "218 moves in the richest position");
+
+    const char* rejected[] = {
+        // 264 legal moves, more than a MoveList holds
+        "1QQQQQQQ/QQ5Q/Q6Q/Q6Q/R6Q/Q6Q/Q6Q/KQQNQQQk w - - 0 1",
+        // No black king, then two white kings
+        "8/8/8/8/8/8/8/K7 w - - 0 1",
+        "k7/8/8/8/8/8/8/K6K w - - 0 1",
+        // Nine white pawns
+        "k7/8/8/8/8/P7/PPPPPPPP/K7 w - - 0 1",
+        // Pawns on the last and the first row
+        "P3k3/8/8/8/8/8/8/4K3 w - - 0 1",
+        "4k3/8/8/8/8/8/8/p3K3 b - - 0 1",
+        // Black to move while the white king is in check
+        "4k3/8/8/8/8/8/8/r3K3 b - - 0 1",
+    };
+    for (const char* fen : rejected) {
+        Chess position;
+        if (position.loadFen(fen)) {
+            std::fprintf(stderr, "FAILED: accepted %s\n", fen);
+            ++failures;
+        }
+    }
+
+    // A rejected FEN leaves the position alone
+    Chess position;
+    position.loadFen(accepted[1]);
+    std::string before = position.toFen();
+    position.loadFen(rejected[0]);
+    expect(position.toFen() == before, "position unchanged after a rejected FEN");
+
+    if (failures == 0) {
+        std::printf("fen_validation: all checks passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
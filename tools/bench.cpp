@@ -0,0 +1,301 @@
+// Microbenchmarks for the rules engine hot paths.
+//
+//   bench [--filter TEXT] [--time MS] [--stats FILE] [--trace FILE]
+//
+// Times isValidMove, getValidMoves, attackersTo, hasAnyLegalMove,
+// isCheckmate/isStalemate and movePiece over a fixed corpus of opening,
+// middlegame, endgame and check-heavy positions. Each benchmark runs once
+// per category, for at least --time milliseconds (default 200), and prints
+// calls, ns/op and heap allocations/op.
+//
+// The last line is a signature: a hash of every result the benchmarks
+// computed on their first pass. It depends only on what the calls return,
+// not on timing, so a change to Chess.cpp that keeps the signature and
+// lowers ns/op is a pure speedup. --filter keeps the benchmarks whose name
+// contains TEXT (the signature then covers only those).
+//
+// In a build with CHESS_INSTRUMENT, --stats writes the engine's call counts
+// and latency histograms as JSON and --trace writes a Chrome trace of each
+// benchmark's first pass.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include "Chess.h"
+#include "Instrumentation.h"
+
+namespace {
+
+// Heap allocations made by this process; single-threaded, so a plain counter
+std::uint64_t allocations = 0;
+
+struct CorpusPosition {
+    const char *category;
+    const char *fen;
+};
+
+const CorpusPosition CORPUS[] = {
+    {"opening", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+    {"opening", "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq c6 0 2"},
+    {"opening", "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3"},
+    {"opening", "rnbqkb1r/ppp2ppp/4pn2/3p4/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 2 4"},
+    {"middlegame", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+    {"middlegame", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"},
+    {"middlegame", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"},
+    {"middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"},
+    {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+    {"endgame", "8/8/8/4k3/8/8/4P3/4K3 w - - 0 1"},
+    {"endgame", "8/5pk1/6p1/8/3R4/6P1/r4PK1/8 w - - 0 1"},
+    {"endgame", "8/8/3k4/8/8/1q6/5PPP/6K1 b - - 0 1"},
+    {"check", "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3"},
+    {"check", "r1bqkbnr/pppp1Qpp/2n5/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4"},
+    {"check", "4k3/8/8/8/8/5n2/8/4K2r w - - 0 1"},
+    {"check", "r3k2r/8/8/8/4Q3/8/8/R3K2R b KQkq - 0 1"},
+    {"check", "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"},
+};
+
+const char *const CATEGORIES[] = {"opening", "middlegame", "endgame", "check"};
+
+struct Entry {
+    Chess position;
+    std::vector<Move> moves;  // legal moves of the side to move
+};
+
+// One pass of a benchmark over some positions; adds the number of calls
+// made to calls and returns a hash of what they returned
+using Pass = std::uint64_t (*)(std::vector<Entry>& entries, std::uint64_t& calls);
+
+std::uint64_t mix(std::uint64_t hash, std::uint64_t value) {
+    return (hash ^ value) * 0x100000001B3ULL;
+}
+
+PieceColor opponent(PieceColor color) {
+    return color == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE;
+}
+
+std::uint64_t isValidMovePass(std::vector<Entry>& entries, std::uint64_t& calls) {
+    std::uint64_t hash = 0;
+    for (Entry &entry : entries) {
+        const Chess &position = entry.position;
+        Bitboard own = position.getPieces(position.getCurrentPlayer(), PieceType::EMPTY);
+        while (own) {
+            int from = popLsb(own);
+            for (int to = 0; to < 64; ++to) {
+                bool valid = position.isValidMove(rowOf(from), colOf(from), rowOf(to), colOf(to));
+                hash = mix(hash, valid ? static_cast<std::uint64_t>(from * 64 + to) : 0);
+                ++calls;
+            }
+        }
+    }
+    return hash;
+}
+
+std::uint64_t getValidMovesPass(std::vector<Entry>& entries, std::uint64_t& calls) {
+    std::uint64_t hash = 0;
+    for (Entry &entry : entries) {
+        const Chess &position = entry.position;
+        Bitboard own = position.getPieces(position.getCurrentPlayer(), PieceType::EMPTY);
+        while (own) {
+            int from = popLsb(own);
+            for (Move move : position.getValidMoves(rowOf(from), colOf(from))) {
+                hash = mix(hash, move.raw());
+            }
+            ++calls;
+        }
+    }
+    return hash;
+}
+
+std::uint64_t attackersToPass(std::vector<Entry>& entries, std::uint64_t& calls) {
+    std::uint64_t hash = 0;
+    for (Entry &entry : entries) {
+        for (int square = 0; square < 64; ++square) {
+            hash = mix(hash, entry.position.attackersTo(rowOf(square), colOf(square)));
+            ++calls;
+        }
+    }
+    return hash;
+}
+
+std::uint64_t hasAnyLegalMovePass(std::vector<Entry>& entries, std::uint64_t& calls) {
+    std::uint64_t hash = 0;
+    for (Entry &entry : entries) {
+        PieceColor toMove = entry.position.getCurrentPlayer();
+        hash = mix(hash, entry.position.hasAnyLegalMove(toMove) ? 1 : 0);
+        hash = mix(hash, entry.position.hasAnyLegalMove(opponent(toMove)) ? 1 : 0);
+        calls += 2;
+    }
+    return hash;
+}
+
+// The status is cached per position, so each call follows a move: this is
+// the question the GUI asks after every move
+std::uint64_t gameOverPass(std::vector<Entry>& entries, std::uint64_t& calls) {
+    std::uint64_t hash = 0;
+    for (Entry &entry : entries) {
+        for (Move move : entry.moves) {
+            entry.position.makeMove(move);
+            bool checkmate = entry.position.isCheckmate();
+            bool stalemate = entry.position.isStalemate();
+            entry.position.unmakeMove();
+            hash = mix(hash, (checkmate ? 2 : 0) | (stalemate ? 1 : 0));
+            ++calls;
+        }
+    }
+    return hash;
+}
+
+std::uint64_t movePiecePass(std::vector<Entry>& entries, std::uint64_t& calls) {
+    std::uint64_t hash = 0;
+    for (Entry &entry : entries) {
+        for (Move move : entry.moves) {
+            // Promotions arrive as pawns; promotePawn is a separate call
+            if (entry.position.movePiece(move.fromRow(), move.fromCol(), move.toRow(), move.toCol())) {
+                hash = mix(hash, entry.position.getPositionKey());
+                entry.position.unmakeMove();
+            }
+            ++calls;
+        }
+    }
+    return hash;
+}
+
+struct Benchmark {
+    const char *name;
+    Pass pass;
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"isValidMove", isValidMovePass},
+    {"getValidMoves", getValidMovesPass},
+    {"attackersTo", attackersToPass},
+    {"hasAnyLegalMove", hasAnyLegalMovePass},
+    {"isCheckmate+isStalemate", gameOverPass},
+    {"movePiece", movePiecePass},
+};
+
+void printUsage() {
+    std::fprintf(stderr,
+        "usage: bench [--filter TEXT] [--time MS] [--stats FILE] [--trace FILE]\n"
+        "  --filter TEXT  only benchmarks whose name contains TEXT\n"
+        "  --time MS      minimum time per benchmark and category (default: 200)\n"
+        "  --stats FILE   write instrumentation counts as JSON (CHESS_INSTRUMENT builds)\n"
+        "  --trace FILE   write a Chrome trace of the first passes (CHESS_INSTRUMENT builds)\n");
+}
+
+bool writeText(const char *path, const std::string& text) {
+    std::FILE *file = std::fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+}
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char *argv[]) {
+    const char *filter = nullptr;
+    const char *statsPath = nullptr;
+    const char *tracePath = nullptr;
+    double minSeconds = 0.2;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            minSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (std::strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            statsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::printf("%-24s %-11s %12s %10s %10s\n", "benchmark", "positions", "calls", "ns/op", "allocs/op");
+
+    std::uint64_t signature = 0;
+    for (const Benchmark &benchmark : BENCHMARKS) {
+        if (filter && !std::strstr(benchmark.name, filter)) {
+            continue;
+        }
+
+        for (const char *category : CATEGORIES) {
+            std::vector<Entry> entries;
+            for (const CorpusPosition &corpus : CORPUS) {
+                if (std::strcmp(corpus.category, category) != 0) {
+                    continue;
+                }
+                Entry entry;
+                if (!entry.position.loadFen(corpus.fen)) {
+                    std::fprintf(stderr, "bad corpus position: %s\n", corpus.fen);
+                    return 1;
+                }
+                for (Move move : entry.position.generateMoves(entry.position.getCurrentPlayer())) {
+                    entry.moves.push_back(move);
+                }
+                entries.push_back(std::move(entry));
+            }
+
+            // The first pass gives the signature; passes repeat until the
+            // minimum time has gone by
+            std::uint64_t calls = 0;
+            std::uint64_t startAllocations = allocations;
+            auto start = std::chrono::steady_clock::now();
+            if (tracePath) {
+                Instrumentation::startTrace(1 << 20);
+            }
+            signature = mix(signature, benchmark.pass(entries, calls));
+            Instrumentation::stopTrace();
+            double seconds = 0;
+            do {
+                benchmark.pass(entries, calls);
+                seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            } while (seconds < minSeconds);
+            std::uint64_t allocated = allocations - startAllocations;
+
+            std::printf("%-24s %-11s %12llu %10.1f %10.3f\n", benchmark.name, category,
+                        static_cast<unsigned long long>(calls),
+                        calls > 0 ? seconds * 1e9 / static_cast<double>(calls) : 0.0,
+                        calls > 0 ? static_cast<double>(allocated) / static_cast<double>(calls) : 0.0);
+        }
+    }
+
+    std::printf("Signature: %016llX\n", static_cast<unsigned long long>(signature));
+
+    if ((statsPath || tracePath) && !Instrumentation::enabled()) {
+        std::fprintf(stderr, "built without CHESS_INSTRUMENT: stats and trace are empty\n");
+    }
+    if (statsPath && !writeText(statsPath, Instrumentation::toJson(Instrumentation::collect()))) {
+        std::fprintf(stderr, "cannot write %s\n", statsPath);
+        return 1;
+    }
+    if (tracePath && !writeText(tracePath, Instrumentation::chromeTrace())) {
+        std::fprintf(stderr, "cannot write %s\n", tracePath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+// Batch position status: legal-move count and check/mate/stalemate for every
+// FEN in a file, one per line.
+//
+//   fenbatch <file> [--threads N] [--output FILE]
+//
+// The input is memory-mapped and split into one slice per thread at line
+// boundaries. With --output, each input line gets one result line, in input
+// order: "<legal moves> <ongoing|check|checkmate|stalemate>", or "invalid".
+// Counts and throughput go to stderr.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Chess.h"
+#include "MappedFile.h"
+
+namespace {
+
+void printUsage() {
+    std::fprintf(stderr,
+        "usage: fenbatch <file> [--threads N] [--output FILE]\n"
+        "  --threads N   worker threads (default: all cores)\n"
+        "  --output F    write one result line per input line to F\n");
+}
+
+struct Totals {
+    std::uint64_t positions = 0;
+    std::uint64_t invalid = 0;
+    std::uint64_t checks = 0;
+    std::uint64_t checkmates = 0;
+    std::uint64_t stalemates = 0;
+    std::uint64_t legalMoves = 0;
+};
+
+// Results for one slice of the input
+struct Slice {
+    std::string_view text;
+    std::string output;
+    Totals totals;
+};
+
+void appendNumber(std::string& out, int value) {
+    char digits[12];
+    int length = std::snprintf(digits, sizeof(digits), "%d", value);
+    out.append(digits, static_cast<std::size_t>(length));
+}
+
+void processSlice(Slice& slice, bool keepOutput) {
+    Chess position;
+    std::string_view text = slice.text;
+    if (keepOutput) {
+        // Results are a few bytes per line, well under the size of a FEN
+        slice.output.reserve(text.size() / 4);
+    }
+
+    while (!text.empty()) {
+        std::size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        ++slice.totals.positions;
+        if (!position.loadFen(line)) {
+            ++slice.totals.invalid;
+            if (keepOutput) {
+                slice.output.append("invalid\n");
+            }
+            continue;
+        }
+
+        const GameStatus& status = position.getStatus();
+        slice.totals.legalMoves += static_cast<std::uint64_t>(status.legalMoveCount);
+        const char* result = "ongoing";
+        if (status.checkmate) {
+            ++slice.totals.checkmates;
+            result = "checkmate";
+        } else if (status.stalemate) {
+            ++slice.totals.stalemates;
+            result = "stalemate";
+        } else if (status.inCheck) {
+            result = "check";
+        }
+        if (status.inCheck) {
+            ++slice.totals.checks;
+        }
+
+        if (keepOutput) {
+            appendNumber(slice.output, status.legalMoveCount);
+            slice.output.push_back(' ');
+            slice.output.append(result);
+            slice.output.push_back('\n');
+        }
+    }
+}
+
+// Splits text into up to count pieces that each end on a line boundary
+std::vector<Slice> splitLines(std::string_view text, int count) {
+    std::vector<Slice> slices;
+    std::size_t begin = 0;
+    for (int i = 0; i < count && begin < text.size(); ++i) {
+        std::size_t end = text.size();
+        if (i + 1 < count) {
+            end = std::min(text.size(), begin + (text.size() - begin) / static_cast<std::size_t>(count - i));
+            end = text.find('\n', end);
+            end = end == std::string_view::npos ? text.size() : end + 1;
+        }
+        Slice slice;
+        slice.text = text.substr(begin, end - begin);
+        slices.push_back(std::move(slice));
+        begin = end;
+    }
+    return slices;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    const char *inputPath = argv[1];
+    const char *outputPath = nullptr;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    MappedFile input;
+    if (!input.open(inputPath)) {
+        std::fprintf(stderr, "cannot read %s\n", inputPath);
+        return 1;
+    }
+
+    std::FILE *output = nullptr;
+    if (outputPath) {
+        output = std::fopen(outputPath, "wb");
+        if (!output) {
+            std::fprintf(stderr, "cannot write %s\n", outputPath);
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<Slice> slices = splitLines(input.view(), threads);
+    std::vector<std::thread> workers;
+    for (Slice &slice : slices) {
+        workers.emplace_back(processSlice, std::ref(slice), output != nullptr);
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Totals totals;
+    for (const Slice &slice : slices) {
+        totals.positions += slice.totals.positions;
+        totals.invalid += slice.totals.invalid;
+        totals.checks += slice.totals.checks;
+        totals.checkmates += slice.totals.checkmates;
+        totals.stalemates += slice.totals.stalemates;
+        totals.legalMoves += slice.totals.legalMoves;
+    }
+
+    if (output) {
+        for (const Slice &slice : slices) {
+            std::fwrite(slice.output.data(), 1, slice.output.size(), output);
+        }
+        std::fclose(output);
+    }
+
+    std::fprintf(stderr, "Positions: %llu (%llu invalid)\n",
+                 static_cast<unsigned long long>(totals.positions),
+                 static_cast<unsigned long long>(totals.invalid));
+    std::fprintf(stderr, "In check: %llu, checkmate: %llu, stalemate: %llu\n",
+                 static_cast<unsigned long long>(totals.checks),
+                 static_cast<unsigned long long>(totals.checkmates),
+                 static_cast<unsigned long long>(totals.stalemates));
+    std::fprintf(stderr, "Legal moves: %llu\n", static_cast<unsigned long long>(totals.legalMoves));
+    std::fprintf(stderr, "Time: %.3f s (%zu threads)\n", seconds, slices.size());
+    std::fprintf(stderr, "Positions/second: %.0f\n", seconds > 0 ? totals.positions / seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Headless perft: counts move generation leaf nodes to a given depth.
+//
+//   perft <depth> [--fen "<fen>"] [--threads N] [--hash MB] [--huge-pages]
+//
+// Prints the node count below each root move, the total, and nodes/second.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "Chess.h"
+#include "Perft.h"
+
+namespace {
+
+void printUsage() {
+    std::fprintf(stderr,
+        "usage: perft <depth> [--fen \"<fen>\"] [--threads N] [--hash MB] [--huge-pages]\n"
+        "  --threads N   worker threads (default: all cores)\n"
+        "  --hash MB     transposition table size, 0 disables it (default: 0)\n");
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    int depth = std::atoi(argv[1]);
+    const char *fen = nullptr;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    long hashMb = 0;
+    bool hugePages = false;
+
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            hashMb = std::atol(argv[++i]);
+        } else if (std::strcmp(argv[i], "--huge-pages") == 0) {
+            hugePages = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (depth < 1) {
+        std::fprintf(stderr, "depth must be at least 1\n");
+        return 1;
+    }
+
+    Chess position;
+    if (fen && !position.loadFen(fen)) {
+        std::fprintf(stderr, "invalid FEN: %s\n", fen);
+        return 1;
+    }
+
+    std::unique_ptr<PerftTable> table;
+    if (hashMb > 0) {
+        table = std::make_unique<PerftTable>(static_cast<std::size_t>(hashMb), hugePages);
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<PerftResult> results = perftDivide(position, depth, threads, table.get());
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::uint64_t total = 0;
+    for (const PerftResult &result : results) {
+        std::printf("%s: %llu\n", result.move.toUci().c_str(),
+                    static_cast<unsigned long long>(result.nodes));
+        total += result.nodes;
+    }
+
+    std::printf("\nNodes searched: %llu\n", static_cast<unsigned long long>(total));
+    std::printf("Time: %.3f s (%d threads%s)\n", seconds, threads, table ? ", hashed" : "");
+    std::printf("Nodes/second: %.0f\n", seconds > 0 ? total / seconds : 0.0);
+    return 0;
+}
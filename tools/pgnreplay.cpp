@@ -0,0 +1,141 @@
+// Replays every game of a PGN file, checking that each move is legal.
+//
+//   pgnreplay <file> [--threads N] [--errors N]
+//
+// The file is memory-mapped and handed out to the threads in blocks; a
+// thread replays the games that start inside the blocks it takes. Memory
+// use is the same for any file size. Prints the games that fail (up to
+// --errors of them, with their byte offset), then totals and throughput.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Chess.h"
+#include "MappedFile.h"
+#include "Pgn.h"
+
+namespace {
+
+// Large enough that claiming a block is rare, small enough to balance the
+// threads on the last part of the file
+constexpr std::size_t BLOCK_SIZE = 4 << 20;
+
+void printUsage() {
+    std::fprintf(stderr,
+        "usage: pgnreplay <file> [--threads N] [--errors N]\n"
+        "  --threads N   worker threads (default: all cores)\n"
+        "  --errors N    failed games to print (default: 10)\n");
+}
+
+struct Shared {
+    std::string_view text;
+    std::atomic<std::size_t> nextBlock{0};
+    std::atomic<std::uint64_t> games{0};
+    std::atomic<std::uint64_t> plies{0};
+    std::atomic<std::uint64_t> failed{0};
+    std::mutex errorMutex;
+    long errorsToPrint = 0;
+};
+
+void replayBlocks(Shared& shared) {
+    Chess position;
+    std::uint64_t games = 0;
+    std::uint64_t plies = 0;
+    std::uint64_t failed = 0;
+
+    for (;;) {
+        std::size_t begin = shared.nextBlock.fetch_add(BLOCK_SIZE, std::memory_order_relaxed);
+        if (begin >= shared.text.size()) {
+            break;
+        }
+        std::size_t end = begin + BLOCK_SIZE;
+
+        // Games belong to the block they start in
+        PgnReader reader(shared.text, begin == 0 ? 0 : findGameStart(shared.text, begin));
+        PgnGame game;
+        while (reader.next(game) && game.offset < end) {
+            ReplayResult result = replayGame(game, position);
+            ++games;
+            plies += static_cast<std::uint64_t>(result.plies);
+            if (!result.ok()) {
+                ++failed;
+                std::lock_guard<std::mutex> lock(shared.errorMutex);
+                if (shared.errorsToPrint > 0) {
+                    --shared.errorsToPrint;
+                    std::fprintf(stderr, "game at byte %zu: cannot play \"%.*s\" after %d plies\n",
+                                 game.offset, static_cast<int>(result.error.size()),
+                                 result.error.data(), result.plies);
+                }
+            }
+        }
+    }
+
+    shared.games += games;
+    shared.plies += plies;
+    shared.failed += failed;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    const char *path = argv[1];
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    long errors = 10;
+
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--errors") == 0 && i + 1 < argc) {
+            errors = std::atol(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    MappedFile input;
+    if (!input.open(path)) {
+        std::fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+
+    Shared shared;
+    shared.text = input.view();
+    shared.errorsToPrint = errors;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(replayBlocks, std::ref(shared));
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::uint64_t games = shared.games;
+    std::uint64_t plies = shared.plies;
+    std::printf("Games: %llu (%llu failed)\n", static_cast<unsigned long long>(games),
+                static_cast<unsigned long long>(shared.failed.load()));
+    std::printf("Moves: %llu\n", static_cast<unsigned long long>(plies));
+    std::printf("Time: %.3f s (%d threads)\n", seconds, threads);
+    std::printf("Games/second: %.0f\n", seconds > 0 ? games / seconds : 0.0);
+    std::printf("Moves/second: %.0f\n", seconds > 0 ? plies / seconds : 0.0);
+    return shared.failed > 0 ? 2 : 0;
+}
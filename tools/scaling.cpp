@@ -0,0 +1,125 @@
+// Lazy-SMP scaling: time-to-depth of the search at several thread counts.
+//
+//   scaling <depth> [--fen "<fen>"] [--threads 1,2,4,...] [--hash MB] [--huge-pages]
+//
+// Every run starts from an empty hash table. Speedup is relative to the
+// first thread count in the list.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Chess.h"
+#include "Search.h"
+
+namespace {
+
+const char *const DEFAULT_FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8",
+};
+
+void printUsage() {
+    std::fprintf(stderr,
+        "usage: scaling <depth> [--fen \"<fen>\"] [--threads 1,2,4,...] [--hash MB] [--huge-pages]\n"
+        "  --fen F       position to search (default: three built-in positions)\n"
+        "  --threads L   comma separated thread counts (default: 1,2,4,8,16,32)\n"
+        "  --hash MB     shared transposition table size (default: 256)\n");
+}
+
+std::vector<int> parseThreadList(const char *text) {
+    std::vector<int> counts;
+    while (*text) {
+        int count = std::atoi(text);
+        if (count > 0) {
+            counts.push_back(count);
+        }
+        const char *comma = std::strchr(text, ',');
+        if (!comma) {
+            break;
+        }
+        text = comma + 1;
+    }
+    return counts;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    int depth = std::atoi(argv[1]);
+    std::vector<std::string> fens;
+    std::vector<int> threadCounts = {1, 2, 4, 8, 16, 32};
+    long hashMb = 256;
+    bool hugePages = false;
+
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+            fens.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCounts = parseThreadList(argv[++i]);
+        } else if (std::strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            hashMb = std::atol(argv[++i]);
+        } else if (std::strcmp(argv[i], "--huge-pages") == 0) {
+            hugePages = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (depth < 1 || depth >= Search::MAX_PLY || threadCounts.empty() || hashMb < 1) {
+        printUsage();
+        return 1;
+    }
+    if (fens.empty()) {
+        fens.assign(std::begin(DEFAULT_FENS), std::end(DEFAULT_FENS));
+    }
+
+    std::vector<Chess> positions(fens.size());
+    for (std::size_t i = 0; i < fens.size(); ++i) {
+        if (!positions[i].loadFen(fens[i])) {
+            std::fprintf(stderr, "invalid FEN: %s\n", fens[i].c_str());
+            return 1;
+        }
+    }
+
+    Search search;
+    search.setHashSize(static_cast<std::size_t>(hashMb), hugePages);
+
+    std::printf("Depth %d, %zu position(s), %ld MB hash\n\n", depth, positions.size(), hashMb);
+    std::printf("%8s %12s %14s %14s %8s\n", "threads", "time (ms)", "nodes", "nodes/s", "speedup");
+
+    double baseline = 0;
+    for (int threads : threadCounts) {
+        search.setThreads(threads);
+
+        // Time to depth, summed over the positions
+        std::int64_t totalMs = 0;
+        std::uint64_t totalNodes = 0;
+        for (const Chess &position : positions) {
+            search.clearHash();
+            auto start = std::chrono::steady_clock::now();
+            search.bestMove(position, 0, depth);
+            totalMs += std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            totalNodes += search.lastInfo().nodes;
+        }
+
+        if (baseline == 0) {
+            baseline = static_cast<double>(totalMs > 0 ? totalMs : 1);
+        }
+        std::printf("%8d %12lld %14llu %14.0f %8.2f\n", threads,
+                    static_cast<long long>(totalMs), static_cast<unsigned long long>(totalNodes),
+                    totalMs > 0 ? totalNodes * 1000.0 / totalMs : 0.0,
+                    baseline / (totalMs > 0 ? totalMs : 1));
+    }
+    return 0;
+}
@@ -0,0 +1,590 @@
+// Endgame tablebase generator.
+//
+//   tbgen <table>... [--dir DIR] [--threads N]
+//
+// Builds each named table ("KQvK", "KRvK", "KPvK", "KBNvK", ...) into
+// DIR/<name>.ctb, first building the smaller tables its captures and
+// promotions lead to unless DIR already has them. Tables hold up to five
+// pieces; a five-piece table needs about 4 bytes of memory per index while
+// it is built (1.3 GB without pawns).
+//
+// Each table is solved by retrograde analysis, one distance to mate at a
+// time. Every position is first set up with Chess: checkmates are lost in
+// 0, and captures and promotions are scored from the smaller tables. Then,
+// for d = 0, 1, 2, ...: the positions one move before a loss in d plies
+// win in d + 1; and a position one move before a win in d plies loses in
+// d + 1 once every one of its moves is shown to lead to a win for the
+// opponent. Positions never settled are draws. Each step is spread over
+// the threads.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Chess.h"
+#include "Tablebase.h"
+
+namespace {
+
+// Entry values while a table is built: pliesToMate + 1 once settled, as
+// in the file, and two markers
+constexpr std::uint16_t UNSETTLED = 0;
+constexpr std::uint16_t INVALID = 0xFFFF;
+
+// Indices handed to a thread at a time
+constexpr std::uint64_t CHUNK = 4096;
+
+void printUsage() {
+    std::fprintf(stderr,
+        "usage: tbgen <table>... [--dir DIR] [--threads N]\n"
+        "  <table>       material such as KQvK or KBNvK, white first\n"
+        "  --dir DIR     where tables are read and written (default: .)\n"
+        "  --threads N   worker threads (default: all cores)\n");
+}
+
+// Calls body(begin, end, worker) over [0, count) in chunks, on threads
+template <typename Body>
+void parallelFor(int threads, std::uint64_t count, Body body) {
+    std::atomic<std::uint64_t> next{0};
+    auto work = [&](int worker) {
+        for (;;) {
+            std::uint64_t begin = next.fetch_add(CHUNK, std::memory_order_relaxed);
+            if (begin >= count) {
+                break;
+            }
+            body(begin, std::min(count, begin + CHUNK), worker);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(work, i);
+    }
+    work(0);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+bool isWin(std::uint16_t value) {
+    return value != UNSETTLED && value != INVALID && (value - 1) % 2 == 1;
+}
+
+bool isCaptureOrPromotion(Move move) {
+    return move.isCapture() || move.isPromotion();
+}
+
+class Generator {
+public:
+    Generator(const TablebaseLayout& layout, const Tablebase& smaller, int threads)
+        : layout(layout), smaller(smaller), threads(threads), size(layout.size()),
+          values(new std::atomic<std::uint16_t>[size]()),
+          candidateAt(new std::atomic<std::uint16_t>[size]()),
+          found(static_cast<std::size_t>(threads)) {}
+
+    // False if a smaller table it needs is not loaded
+    bool run();
+    bool write(const std::string& path) const;
+
+    std::uint64_t legalPositions = 0;
+    std::uint64_t wins = 0;
+    std::uint64_t losses = 0;
+    int longestWin = 0;
+    std::uint64_t longestWinIndex = 0;
+
+private:
+    const TablebaseLayout& layout;
+    const Tablebase& smaller;
+    int threads;
+    std::uint64_t size;
+    std::unique_ptr<std::atomic<std::uint16_t>[]> values;
+    // Last distance + 1 at which a position was checked for a loss
+    std::unique_ptr<std::atomic<std::uint16_t>[]> candidateAt;
+    // Positions to visit at each distance: settled there, or winning there
+    // by a capture unless settled sooner
+    std::vector<std::vector<std::uint64_t>> byDistance;
+    // What each thread found in the current step, as (distance, index)
+    std::vector<std::vector<std::pair<int, std::uint64_t>>> found;
+    std::atomic<bool> missingTable{false};
+
+    bool setUp(std::uint64_t index, Chess& position);
+    void scoreExits(std::uint64_t index, Chess& position, int worker);
+    int provenLoss(std::uint64_t index, Chess& position);
+    template <typename Visit>
+    void forEachPredecessor(std::uint64_t index, Visit visit) const;
+    void collectFound();
+};
+
+// Loads the position of an index; false if it is not a legal position
+bool Generator::setUp(std::uint64_t index, Chess& position) {
+    TablebaseLayout::Squares squares;
+    bool whiteToMove;
+    if (!layout.decode(index, squares, whiteToMove) || layout.index(squares, whiteToMove) != index) {
+        return false;
+    }
+    char fen[Chess::MAX_FEN_LENGTH];
+    int length = layout.writeFen(squares, whiteToMove, fen);
+    // loadFen also turns away positions where the side that just moved is
+    // in check
+    return position.loadFen(std::string_view(fen, static_cast<std::size_t>(length)));
+}
+
+// First look at a position: checkmate, or results through the moves that
+// leave the table
+void Generator::scoreExits(std::uint64_t index, Chess& position, int worker) {
+    MoveList moves = position.generateMoves(position.getCurrentPlayer());
+    if (moves.size() == 0) {
+        if (position.isCheck()) {
+            values[index].store(1, std::memory_order_relaxed);
+            found[worker].push_back({0, index});
+        }
+        return;
+    }
+
+    int fastestWin = -1;
+    int slowestLoss = 0;
+    bool allLose = true;
+    for (Move move : moves) {
+        if (!isCaptureOrPromotion(move)) {
+            allLose = false;
+            continue;
+        }
+        position.makeMove(move);
+        TablebaseResult result;
+        bool known = smaller.probe(position, result);
+        position.unmakeMove();
+        if (!known) {
+            missingTable = true;
+            return;
+        }
+
+        if (result.outcome == TablebaseResult::LOSS) {
+            int plies = result.pliesToMate + 1;
+            fastestWin = fastestWin < 0 ? plies : std::min(fastestWin, plies);
+        } else if (result.outcome == TablebaseResult::WIN) {
+            slowestLoss = std::max(slowestLoss, result.pliesToMate + 1);
+        } else {
+            allLose = false;
+        }
+    }
+
+    if (fastestWin >= 0) {
+        found[worker].push_back({fastestWin, index});
+    } else if (allLose) {
+        values[index].store(static_cast<std::uint16_t>(slowestLoss + 1), std::memory_order_relaxed);
+        found[worker].push_back({slowestLoss, index});
+    }
+}
+
+// Plies to mate if every move from the position is known to lose, else -1
+int Generator::provenLoss(std::uint64_t index, Chess& position) {
+    if (!setUp(index, position)) {
+        return -1;
+    }
+    MoveList moves = position.generateMoves(position.getCurrentPlayer());
+    int slowest = -1;
+    for (Move move : moves) {
+        position.makeMove(move);
+        int plies = -1;
+        if (isCaptureOrPromotion(move)) {
+            TablebaseResult result;
+            if (smaller.probe(position, result) && result.outcome == TablebaseResult::WIN) {
+                plies = result.pliesToMate;
+            }
+        } else {
+            std::uint16_t value = values[layout.index(position)].load(std::memory_order_relaxed);
+            if (isWin(value)) {
+                plies = value - 1;
+            }
+        }
+        position.unmakeMove();
+        if (plies < 0) {
+            return -1;
+        }
+        slowest = std::max(slowest, plies);
+    }
+    return slowest < 0 ? -1 : slowest + 1;
+}
+
+// Calls visit(index) for the legal positions one move before this one
+// within the table: the side not to move takes back a move, without
+// uncapturing or unpromoting
+template <typename Visit>
+void Generator::forEachPredecessor(std::uint64_t index, Visit visit) const {
+    TablebaseLayout::Squares squares;
+    bool whiteToMove;
+    layout.decode(index, squares, whiteToMove);
+    bool moverWhite = !whiteToMove;
+
+    Bitboard occupied = 0;
+    for (int i = 0; i < layout.pieceCount(); ++i) {
+        occupied |= squareBB(squares[i]);
+    }
+
+    for (int i = 0; i < layout.pieceCount(); ++i) {
+        const Piece& piece = layout.piece(i);
+        if ((piece.color == PieceColor::WHITE) != moverWhite) {
+            continue;
+        }
+
+        int to = squares[i];
+        Bitboard from = 0;
+        switch (piece.type) {
+            case PieceType::KING:   from = kingAttacksFrom(to); break;
+            case PieceType::KNIGHT: from = knightAttacksFrom(to); break;
+            case PieceType::BISHOP: from = bishopAttacks(to, occupied); break;
+            case PieceType::ROOK:   from = rookAttacks(to, occupied); break;
+            case PieceType::QUEEN:  from = queenAttacks(to, occupied); break;
+            case PieceType::PAWN: {
+                // White pawns move towards row 0; a pawn never starts on
+                // its own first rank
+                int back = moverWhite ? 8 : -8;
+                int row = rowOf(to);
+                bool single = moverWhite ? row <= 5 : row >= 2;
+                if (single) {
+                    from = squareBB(to + back);
+                    if ((row == (moverWhite ? 4 : 3)) && !(occupied & from)) {
+                        from |= squareBB(to + 2 * back);
+                    }
+                }
+                break;
+            }
+            default: break;
+        }
+
+        from &= ~occupied;
+        while (from) {
+            TablebaseLayout::Squares before = squares;
+            before[i] = popLsb(from);
+            std::uint64_t predecessor = layout.index(before, moverWhite);
+            if (values[predecessor].load(std::memory_order_relaxed) != INVALID) {
+                visit(predecessor);
+            }
+        }
+    }
+}
+
+void Generator::collectFound() {
+    for (auto &list : found) {
+        for (const auto &entry : list) {
+            std::size_t distance = static_cast<std::size_t>(entry.first);
+            if (distance >= byDistance.size()) {
+                byDistance.resize(distance + 1);
+            }
+            byDistance[distance].push_back(entry.second);
+        }
+        list.clear();
+    }
+}
+
+bool Generator::run() {
+    parallelFor(threads, size, [&](std::uint64_t begin, std::uint64_t end, int worker) {
+        Chess position;
+        for (std::uint64_t index = begin; index < end; ++index) {
+            if (setUp(index, position)) {
+                scoreExits(index, position, worker);
+            } else {
+                values[index].store(INVALID, std::memory_order_relaxed);
+            }
+        }
+    });
+    if (missingTable) {
+        return false;
+    }
+    collectFound();
+
+    std::vector<std::uint64_t> candidates;
+    for (std::size_t distance = 0; distance < byDistance.size(); ++distance) {
+        std::vector<std::uint64_t> positions = std::move(byDistance[distance]);
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+        // Wins by a capture or promotion count from here unless a faster
+        // one was found
+        auto settled = static_cast<std::uint16_t>(distance + 1);
+        for (std::uint64_t index : positions) {
+            std::uint16_t expected = UNSETTLED;
+            values[index].compare_exchange_strong(expected, settled, std::memory_order_relaxed);
+        }
+
+        bool losses = distance % 2 == 0;
+        std::vector<std::vector<std::uint64_t>> threadCandidates(static_cast<std::size_t>(threads));
+        parallelFor(threads, positions.size(), [&](std::uint64_t begin, std::uint64_t end, int worker) {
+            for (std::uint64_t i = begin; i < end; ++i) {
+                std::uint64_t index = positions[i];
+                if (values[index].load(std::memory_order_relaxed) != settled) {
+                    continue;
+                }
+                forEachPredecessor(index, [&](std::uint64_t predecessor) {
+                    if (losses) {
+                        std::uint16_t expected = UNSETTLED;
+                        if (values[predecessor].compare_exchange_strong(expected, static_cast<std::uint16_t>(settled + 1),
+                                                                       std::memory_order_relaxed)) {
+                            found[worker].push_back({static_cast<int>(distance + 1), predecessor});
+                        }
+                    } else if (values[predecessor].load(std::memory_order_relaxed) == UNSETTLED &&
+                               candidateAt[predecessor].exchange(settled, std::memory_order_relaxed) != settled) {
+                        threadCandidates[worker].push_back(predecessor);
+                    }
+                });
+            }
+        });
+
+        if (!losses) {
+            candidates.clear();
+            for (const auto &list : threadCandidates) {
+                candidates.insert(candidates.end(), list.begin(), list.end());
+            }
+            parallelFor(threads, candidates.size(), [&](std::uint64_t begin, std::uint64_t end, int worker) {
+                Chess position;
+                for (std::uint64_t i = begin; i < end; ++i) {
+                    std::uint64_t index = candidates[i];
+                    int plies = provenLoss(index, position);
+                    std::uint16_t expected = UNSETTLED;
+                    if (plies >= 0 && values[index].compare_exchange_strong(
+                            expected, static_cast<std::uint16_t>(plies + 1), std::memory_order_relaxed)) {
+                        found[worker].push_back({plies, index});
+                    }
+                }
+            });
+        }
+        collectFound();
+    }
+
+    for (std::uint64_t index = 0; index < size; ++index) {
+        std::uint16_t value = values[index].load(std::memory_order_relaxed);
+        if (value == INVALID) {
+            continue;
+        }
+        ++legalPositions;
+        if (isWin(value)) {
+            ++wins;
+            if (value - 1 > longestWin) {
+                longestWin = value - 1;
+                longestWinIndex = index;
+            }
+        } else if (value != UNSETTLED) {
+            ++losses;
+        }
+    }
+    return true;
+}
+
+bool Generator::write(const std::string& path) const {
+    int longest = 0;
+    for (std::uint64_t index = 0; index < size; ++index) {
+        std::uint16_t value = values[index].load(std::memory_order_relaxed);
+        if (value != INVALID) {
+            longest = std::max(longest, static_cast<int>(value));
+        }
+    }
+    int bits = 1;
+    while ((1 << bits) <= longest) {
+        ++bits;
+    }
+
+    TablebaseHeader header;
+    header.bitsPerEntry = bits;
+    header.name = layout.name();
+    header.entries = size;
+
+    // Packed entries and the zero padding after them
+    std::vector<unsigned char> data(TablebaseHeader::SIZE + (size * bits + 7) / 8 + 8, 0);
+    header.write(reinterpret_cast<char*>(data.data()));
+    unsigned char* entries = data.data() + TablebaseHeader::SIZE;
+    for (std::uint64_t index = 0; index < size; ++index) {
+        std::uint16_t value = values[index].load(std::memory_order_relaxed);
+        if (value == UNSETTLED || value == INVALID) {
+            continue;
+        }
+        std::uint64_t bit = index * static_cast<std::uint64_t>(bits);
+        for (int b = 0; b < bits; ++b, ++bit) {
+            if (value & (1 << b)) {
+                entries[bit / 8] |= static_cast<unsigned char>(1 << (bit % 8));
+            }
+        }
+    }
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+// The stronger side of a balance plays white in its file name: more
+// pieces, or better ones
+TablebaseLayout whiteStronger(const TablebaseLayout& layout) {
+    std::string name = layout.name();
+    std::size_t split = name.find('v');
+    std::string white = name.substr(0, split);
+    std::string black = name.substr(split + 1);
+    const char* order = "KQRBNP";
+    auto weaker = [&](const std::string& a, const std::string& b) {
+        if (a.size() != b.size()) {
+            return a.size() < b.size();
+        }
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (a[i] != b[i]) {
+                return std::strchr(order, a[i]) > std::strchr(order, b[i]);
+            }
+        }
+        return false;
+    };
+    return weaker(white, black) ? layout.swapped() : layout;
+}
+
+char pieceLetter(PieceType type) {
+    switch (type) {
+        case PieceType::KING:   return 'K';
+        case PieceType::QUEEN:  return 'Q';
+        case PieceType::ROOK:   return 'R';
+        case PieceType::BISHOP: return 'B';
+        case PieceType::KNIGHT: return 'N';
+        default:                return 'P';
+    }
+}
+
+// Balances one capture and/or promotion away
+std::vector<TablebaseLayout> smallerLayouts(const TablebaseLayout& layout) {
+    const PieceType promotions[] = {PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT};
+    std::vector<TablebaseLayout> result;
+    int count = layout.pieceCount();
+
+    // removed or promoted == count means none
+    for (int removed = 0; removed <= count; ++removed) {
+        if (removed < count && layout.piece(removed).type == PieceType::KING) {
+            continue;
+        }
+        for (int promoted = 0; promoted <= count; ++promoted) {
+            // A pawn promotes by itself or by taking an enemy piece
+            if (promoted < count && (layout.piece(promoted).type != PieceType::PAWN ||
+                                     (removed < count && layout.piece(removed).color == layout.piece(promoted).color))) {
+                continue;
+            }
+            if (removed == count && promoted == count) {
+                continue;
+            }
+            for (PieceType promotion : promotions) {
+                std::string name;
+                for (PieceColor color : {PieceColor::WHITE, PieceColor::BLACK}) {
+                    if (color == PieceColor::BLACK) {
+                        name += 'v';
+                    }
+                    for (int i = 0; i < count; ++i) {
+                        const Piece& piece = layout.piece(i);
+                        if (i == removed || piece.color != color) {
+                            continue;
+                        }
+                        name += pieceLetter(i == promoted ? promotion : piece.type);
+                    }
+                }
+                TablebaseLayout smaller;
+                if (TablebaseLayout::parse(name, smaller)) {
+                    result.push_back(whiteStronger(smaller));
+                }
+                if (promoted == count) {
+                    break;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+// Builds the table and, first, any smaller one it needs; false on error
+bool build(const TablebaseLayout& layout, const std::string& dir, int threads, Tablebase& tables) {
+    if (tables.covers(layout)) {
+        return true;
+    }
+    for (const TablebaseLayout& smaller : smallerLayouts(layout)) {
+        if (!tables.covers(smaller) && !tables.addTable(dir + "/" + smaller.name() + ".ctb") &&
+            !build(smaller, dir, threads, tables)) {
+            return false;
+        }
+    }
+
+    std::string name = layout.name();
+    std::string path = dir + "/" + name + ".ctb";
+    std::printf("%s: %llu indices\n", name.c_str(), static_cast<unsigned long long>(layout.size()));
+    std::fflush(stdout);
+
+    auto start = std::chrono::steady_clock::now();
+    Generator generator(layout, tables, threads);
+    if (!generator.run()) {
+        std::fprintf(stderr, "%s: a smaller table is missing\n", name.c_str());
+        return false;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!generator.write(path) || !tables.addTable(path)) {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    std::uint64_t draws = generator.legalPositions - generator.wins - generator.losses;
+    std::printf("  positions: %llu (win %llu, draw %llu, loss %llu)\n",
+                static_cast<unsigned long long>(generator.legalPositions),
+                static_cast<unsigned long long>(generator.wins),
+                static_cast<unsigned long long>(draws),
+                static_cast<unsigned long long>(generator.losses));
+    if (generator.longestWin > 0) {
+        TablebaseLayout::Squares squares;
+        bool whiteToMove;
+        char fen[Chess::MAX_FEN_LENGTH];
+        layout.decode(generator.longestWinIndex, squares, whiteToMove);
+        int length = layout.writeFen(squares, whiteToMove, fen);
+        std::printf("  longest mate: %d moves (%.*s)\n", (generator.longestWin + 1) / 2, length, fen);
+    }
+    std::printf("  time: %.3f s (%d threads)\n", seconds, threads);
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> names;
+    std::string dir = ".";
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            names.push_back(argv[i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (names.empty()) {
+        printUsage();
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    Tablebase tables;
+    for (const std::string &name : names) {
+        TablebaseLayout layout;
+        if (!TablebaseLayout::parse(name, layout)) {
+            std::fprintf(stderr, "not a table: %s\n", name.c_str());
+            return 1;
+        }
+        if (!build(layout, dir, threads, tables)) {
+            return 1;
+        }
+    }
+    return 0;
+}
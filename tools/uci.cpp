@@ -0,0 +1,476 @@
+// Headless protocol server: a UCI-compatible subset on stdin/stdout.
+//
+//   uci [--threads N] [--hash MB]
+//
+// Standard commands: uci, isready, ucinewgame, setoption (Threads, Hash),
+// position startpos|fen <fen> [moves ...], go [depth N] [movetime MS]
+// [wtime MS btime MS winc MS binc MS movestogo N] [infinite], go perft N,
+// stop, quit. Extensions for scripts:
+//
+//   perft N       same as "go perft N"
+//   legalmoves    "legalmoves e2e4 g1f3 ..." for the side to move
+//   status        "status <ongoing|checkmate|stalemate|fifty|repetition|material>
+//                 check <0|1> moves N side <w|b>"
+//   stats         "stats {...}": call counts and latency histograms as JSON
+//                 (all zero unless built with CHESS_INSTRUMENT)
+//
+// Input is read in large blocks and replies are collected in a buffer that is
+// written out only when every complete command received so far has been
+// handled, so a client can stream thousands of commands without waiting for
+// each answer. Search output is written as it happens.
+//
+// "go" searches on a separate thread so that "stop" and "isready" are
+// answered while it runs; any other command waits for the search to end.
+// After "go infinite" the bestmove line is held back until "stop" or "quit",
+// even if the search reaches its last depth or finds a mate first.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Chess.h"
+#include "Instrumentation.h"
+#include "Perft.h"
+#include "Search.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int DEFAULT_HASH_MB = 16;
+constexpr int MAX_THREADS = 256;
+
+void printUsage() {
+    std::fprintf(stderr,
+        "usage: uci [--threads N] [--hash MB]\n"
+        "  --threads N   search and perft threads (default: 1)\n"
+        "  --hash MB     transposition table size (default: 16)\n");
+}
+
+// Game state word of the "status" reply when nobody is mated
+const char* drawName(DrawReason reason) {
+    switch (reason) {
+        case DrawReason::STALEMATE: return "stalemate";
+        case DrawReason::FIFTY_MOVES: return "fifty";
+        case DrawReason::REPETITION: return "repetition";
+        case DrawReason::INSUFFICIENT_MATERIAL: return "material";
+        default: return "ongoing";
+    }
+}
+
+// Whatever is available on stdin, up to size bytes; 0 at end of input
+long readInput(char* buffer, std::size_t size) {
+#ifdef _WIN32
+    return _read(0, buffer, static_cast<unsigned>(size));
+#else
+    return static_cast<long>(read(0, buffer, size));
+#endif
+}
+
+// Replies collected until flush(); shared with the search thread
+class Output {
+public:
+    void write(std::string_view text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer.append(text);
+        buffer.push_back('\n');
+    }
+
+    // For output that must not wait for the next read, e.g. search info
+    void writeNow(std::string_view text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer.append(text);
+        buffer.push_back('\n');
+        flushLocked();
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        flushLocked();
+    }
+
+private:
+    std::mutex mutex;
+    std::string buffer;
+
+    void flushLocked() {
+        if (!buffer.empty()) {
+            std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+            std::fflush(stdout);
+            buffer.clear();
+        }
+    }
+};
+
+// Splits stdin into lines, reading whole blocks at a time. Before a read
+// that may block, onIdle() runs so pending replies go out first.
+class LineReader {
+public:
+    template <typename OnIdle>
+    bool next(std::string& line, OnIdle onIdle) {
+        for (;;) {
+            std::size_t end = buffer.find('\n', start);
+            if (end != std::string::npos) {
+                line.assign(buffer, start, end - start);
+                start = end + 1;
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                return true;
+            }
+
+            buffer.erase(0, start);
+            start = 0;
+            onIdle();
+
+            char block[BLOCK_SIZE];
+            long count = readInput(block, sizeof(block));
+            if (count <= 0) {
+                // A last command without a newline still counts
+                if (buffer.empty()) {
+                    return false;
+                }
+                line.swap(buffer);
+                buffer.clear();
+                return true;
+            }
+            buffer.append(block, static_cast<std::size_t>(count));
+        }
+    }
+
+private:
+    static constexpr std::size_t BLOCK_SIZE = 1 << 16;
+
+    std::string buffer;
+    std::size_t start = 0;
+};
+
+std::vector<std::string_view> splitWords(std::string_view text) {
+    std::vector<std::string_view> words;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && (text[i] == ' ' || text[i] == '\t')) {
+            ++i;
+        }
+        std::size_t begin = i;
+        while (i < text.size() && text[i] != ' ' && text[i] != '\t') {
+            ++i;
+        }
+        if (i > begin) {
+            words.push_back(text.substr(begin, i - begin));
+        }
+    }
+    return words;
+}
+
+long toNumber(std::string_view word) {
+    return std::strtol(std::string(word).c_str(), nullptr, 10);
+}
+
+std::string formatScore(int score) {
+    if (score >= Search::MATE_SCORE - Search::MAX_PLY) {
+        return "mate " + std::to_string((Search::MATE_SCORE - score + 1) / 2);
+    }
+    if (score <= -Search::MATE_SCORE + Search::MAX_PLY) {
+        return "mate -" + std::to_string((Search::MATE_SCORE + score) / 2);
+    }
+    return "cp " + std::to_string(score);
+}
+
+class Server {
+public:
+    Server(int threads, long hashMb)
+        : search(threads, static_cast<std::size_t>(hashMb)), threads(threads), hashMb(hashMb) {}
+
+    // At end of input a running search is allowed to finish; an infinite
+    // one never would, so it is stopped
+    ~Server() {
+        if (holdingBestMove) {
+            stopSearch();
+        }
+        waitForSearch();
+    }
+
+    // Returns false on quit
+    bool handle(std::string_view line) {
+        std::vector<std::string_view> words = splitWords(line);
+        if (words.empty()) {
+            return true;
+        }
+
+        std::string_view command = words[0];
+        if (command == "quit") {
+            stopSearch();
+            return false;
+        }
+        if (command == "stop") {
+            stopSearch();
+        } else if (command == "isready") {
+            out.write("readyok");
+        } else if (command == "uci") {
+            out.write("id name Chess");
+            out.write("id author Chess contributors");
+            out.write("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+            out.write("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) +
+                      " min 1 max 65536");
+            out.write("uciok");
+        } else {
+            // Everything else reads or changes the position
+            waitForSearch();
+            if (command == "ucinewgame") {
+                position.resetBoard();
+                search.clearHash();
+            } else if (command == "position") {
+                setPosition(words);
+            } else if (command == "setoption") {
+                setOption(words);
+            } else if (command == "go") {
+                go(words);
+            } else if (command == "perft" && words.size() > 1) {
+                runPerft(static_cast<int>(toNumber(words[1])));
+            } else if (command == "legalmoves") {
+                listMoves();
+            } else if (command == "status") {
+                printStatus();
+            } else if (command == "stats") {
+                out.write("stats " + Instrumentation::toJson(Instrumentation::collect()));
+            } else {
+                out.write("info string unknown command: " + std::string(line));
+            }
+        }
+        return true;
+    }
+
+    void flush() {
+        out.flush();
+    }
+
+private:
+    Chess position;
+    Search search;
+    Output out;
+    std::thread searchThread;
+    int threads;
+    long hashMb;
+    // Set by "go infinite" until "stop" or "quit" lets bestmove out
+    bool holdingBestMove = false;
+    std::mutex holdMutex;
+    std::condition_variable holdReleased;
+
+    void stopSearch() {
+        {
+            std::lock_guard<std::mutex> lock(holdMutex);
+            holdingBestMove = false;
+        }
+        holdReleased.notify_all();
+        search.stop();
+        waitForSearch();
+    }
+
+    void waitForSearch() {
+        if (searchThread.joinable()) {
+            searchThread.join();
+        }
+    }
+
+    void setPosition(const std::vector<std::string_view>& words) {
+        std::size_t i = 1;
+        Chess next;
+        if (i < words.size() && words[i] == "startpos") {
+            ++i;
+        } else if (i < words.size() && words[i] == "fen") {
+            std::string fen;
+            for (++i; i < words.size() && words[i] != "moves"; ++i) {
+                if (!fen.empty()) {
+                    fen.push_back(' ');
+                }
+                fen.append(words[i]);
+            }
+            if (!next.loadFen(fen)) {
+                out.write("info string invalid FEN: " + fen);
+                return;
+            }
+        } else {
+            out.write("info string expected startpos or fen");
+            return;
+        }
+
+        if (i < words.size() && words[i] == "moves") {
+            for (++i; i < words.size(); ++i) {
+                Move move = next.parseUciMove(words[i]);
+                if (move.isNone()) {
+                    out.write("info string illegal move: " + std::string(words[i]));
+                    return;
+                }
+                next.makeMove(move);
+            }
+        }
+        position = next;
+    }
+
+    void setOption(const std::vector<std::string_view>& words) {
+        // setoption name <name> value <value>
+        if (words.size() < 5 || words[1] != "name" || words[3] != "value") {
+            out.write("info string expected setoption name <name> value <value>");
+            return;
+        }
+        long value = toNumber(words[4]);
+        if (words[2] == "Threads" && value >= 1 && value <= MAX_THREADS) {
+            threads = static_cast<int>(value);
+            search.setThreads(threads);
+        } else if (words[2] == "Hash" && value >= 1) {
+            hashMb = value;
+            search.setHashSize(static_cast<std::size_t>(hashMb));
+        } else {
+            out.write("info string unsupported option: " + std::string(words[2]));
+        }
+    }
+
+    void go(const std::vector<std::string_view>& words) {
+        int depth = Search::MAX_PLY - 1;
+        long moveTime = 0;
+        long clock[2] = {0, 0};
+        long increment[2] = {0, 0};
+        long movesToGo = 0;
+        bool infinite = false;
+
+        for (std::size_t i = 1; i < words.size(); ++i) {
+            std::string_view word = words[i];
+            bool hasValue = i + 1 < words.size();
+            if (word == "perft" && hasValue) {
+                runPerft(static_cast<int>(toNumber(words[++i])));
+                return;
+            } else if (word == "depth" && hasValue) {
+                depth = static_cast<int>(toNumber(words[++i]));
+            } else if (word == "movetime" && hasValue) {
+                moveTime = toNumber(words[++i]);
+            } else if (word == "wtime" && hasValue) {
+                clock[0] = toNumber(words[++i]);
+            } else if (word == "btime" && hasValue) {
+                clock[1] = toNumber(words[++i]);
+            } else if (word == "winc" && hasValue) {
+                increment[0] = toNumber(words[++i]);
+            } else if (word == "binc" && hasValue) {
+                increment[1] = toNumber(words[++i]);
+            } else if (word == "movestogo" && hasValue) {
+                movesToGo = toNumber(words[++i]);
+            } else if (word == "infinite") {
+                infinite = true;
+            }
+        }
+        if (depth < 1 || depth >= Search::MAX_PLY) {
+            depth = Search::MAX_PLY - 1;
+        }
+
+        // A slice of the remaining clock, keeping a reserve for the moves after
+        int side = position.getCurrentPlayer() == PieceColor::WHITE ? 0 : 1;
+        if (moveTime <= 0 && clock[side] > 0) {
+            long slice = clock[side] / (movesToGo > 0 ? movesToGo : 30) + increment[side] / 2;
+            moveTime = std::max(1L, std::min(slice, clock[side] / 2));
+        }
+
+        // Cleared here rather than on the search thread, so a "stop" read
+        // before that thread gets going still ends the search
+        search.prepare();
+        holdingBestMove = infinite;
+        searchThread = std::thread([this, depth, moveTime, root = position]() {
+            Move best = search.bestMove(root, static_cast<int>(moveTime), depth,
+                [this](const SearchInfo& info) {
+                    out.writeNow("info depth " + std::to_string(info.depth) +
+                                 " score " + formatScore(info.score) +
+                                 " nodes " + std::to_string(info.nodes) +
+                                 " nps " + std::to_string(info.nodesPerSecond()) +
+                                 " time " + std::to_string(info.elapsedMs) +
+                                 " pv " + info.bestMove.toUci());
+                });
+            {
+                std::unique_lock<std::mutex> lock(holdMutex);
+                holdReleased.wait(lock, [this]() { return !holdingBestMove; });
+            }
+            out.writeNow("bestmove " + (best.isNone() ? std::string("0000") : best.toUci()));
+        });
+    }
+
+    void runPerft(int depth) {
+        if (depth < 1) {
+            out.write("info string perft depth must be at least 1");
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<PerftResult> results = perftDivide(position, depth, threads);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::uint64_t total = 0;
+        for (const PerftResult& result : results) {
+            out.write(result.move.toUci() + ": " + std::to_string(result.nodes));
+            total += result.nodes;
+        }
+        out.write("");
+        out.write("Nodes searched: " + std::to_string(total));
+        out.write("info string perft time " + std::to_string(elapsed) + " ms");
+    }
+
+    void listMoves() {
+        std::string line = "legalmoves";
+        for (Move move : position.generateMoves(position.getCurrentPlayer())) {
+            line.push_back(' ');
+            line += move.toUci();
+        }
+        out.write(line);
+    }
+
+    void printStatus() {
+        const GameStatus& status = position.getStatus();
+        std::string line = "status ";
+        line += status.checkmate ? "checkmate" : drawName(status.drawReason);
+        line += status.inCheck ? " check 1" : " check 0";
+        line += " moves " + std::to_string(status.legalMoveCount);
+        line += position.getCurrentPlayer() == PieceColor::WHITE ? " side w" : " side b";
+        out.write(line);
+    }
+};
+
+}
+
+int main(int argc, char *argv[]) {
+    int threads = 1;
+    long hashMb = DEFAULT_HASH_MB;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            hashMb = std::atol(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (threads < 1 || threads > MAX_THREADS || hashMb < 1) {
+        printUsage();
+        return 1;
+    }
+
+    Server server(threads, hashMb);
+    LineReader input;
+    std::string line;
+    while (input.next(line, [&server]() { server.flush(); })) {
+        if (!server.handle(line)) {
+            break;
+        }
+    }
+    server.flush();
+    return 0;
+}